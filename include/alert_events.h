@@ -0,0 +1,142 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ina_values.h"
+
+// One INA228 limit violation. `timestampUs` is micros() taken by the ALERT
+// interrupt, the values are read right after the flags (raw register codes).
+struct AlertEvent
+{
+  uint32_t timestampUs;
+  uint32_t timestampMs; // millis() when the flags were read
+  uint16_t flags;       // ina::kDiag* limit flags, 0 = cleared before the read
+  int32_t  current;     // ina::CurrentScale
+  int32_t  vBus;        // ina::BusVoltageScale
+};
+
+// Datasheet name of a single DIAG_ALRT limit flag.
+inline const char *alertFlagName(uint16_t flag)
+{
+  switch (flag)
+  {
+    case ina::kDiagTempOver:   return "TMPOL";
+    case ina::kDiagShuntOver:  return "SHNTOL";
+    case ina::kDiagShuntUnder: return "SHNTUL";
+    case ina::kDiagBusOver:    return "BUSOL";
+    case ina::kDiagBusUnder:   return "BUSUL";
+    case ina::kDiagPowerOver:  return "POL";
+    default:                   return "?";
+  }
+}
+
+// Visits the name of every limit flag set in `flags`, highest bit first.
+template <typename Visitor>
+void forEachAlertFlag(uint16_t flags, Visitor &&visit)
+{
+  for (uint16_t flag = ina::kDiagTempOver; flag >= ina::kDiagPowerOver; flag >>= 1)
+  {
+    if ((flags & flag) != 0)
+      visit(alertFlagName(flag));
+  }
+}
+
+// What one DIAG_ALRT read found, see AlertEventLog::update().
+struct AlertRead
+{
+  bool     edge;      // the read answers an ALERT edge it hadn't seen before
+  bool     converted; // a new conversion result is ready
+  bool     event;     // an event is to be recorded with `newFlags`
+  uint16_t newFlags;  // limit flags that were clear at the previous read
+};
+
+// The most recent limit events. A violation that lasts over several alerts
+// is recorded once, when its flag first shows up.
+class AlertEventLog
+{
+public:
+  static constexpr size_t kCapacity = 16;
+
+  AlertEventLog()
+      : m_events()
+      , m_head(0)
+      , m_count(0)
+      , m_total(0)
+      , m_lastReadUs(0)
+      , m_active(0)
+  {
+  }
+
+  // Takes one DIAG_ALRT read, started at `readUs`. `edge` is false when the
+  // read was a poll rather than the answer to an ALERT interrupt, `alertUs`
+  // is the stamp of the newest edge.
+  AlertRead update(uint16_t diag, bool edge, uint32_t alertUs, uint32_t readUs)
+  {
+    const uint16_t limits = diag & ina::kDiagLimitMask;
+    const bool     ready  = (diag & ina::kDiagConversionDone) != 0;
+
+    // An edge from before the previous read was answered by that read: the
+    // conversion completed after the edges were drained, and the read took
+    // its CNVRF and its result.
+    AlertRead read;
+    read.edge     = edge && static_cast<int32_t>(alertUs - m_lastReadUs) >= 0;
+    read.newFlags = limits & ~m_active;
+    m_active      = limits;
+    m_lastReadUs  = readUs;
+
+    // an interrupt without conversion-ready or a limit flag: the violation
+    // was over before the flags were read
+    const bool transient = read.edge && limits == 0 && !ready;
+    read.converted       = ready;
+    read.event           = read.newFlags != 0 || transient;
+    return read;
+  }
+
+  void add(const AlertEvent &event)
+  {
+    m_events[m_head] = event;
+    m_head           = (m_head + 1) % kCapacity;
+    if (m_count < kCapacity)
+    {
+      ++m_count;
+    }
+    ++m_total;
+  }
+
+  // Limit flags seen by the last update().
+  uint16_t active() const
+  {
+    return m_active;
+  }
+
+  size_t count() const
+  {
+    return m_count;
+  }
+
+  // events since boot, including those no longer retained
+  uint32_t total() const
+  {
+    return m_total;
+  }
+
+  // 0 = oldest retained event
+  const AlertEvent &event(size_t index) const
+  {
+    return m_events[(m_head + kCapacity - m_count + index) % kCapacity];
+  }
+
+  const AlertEvent *latest() const
+  {
+    return (m_count > 0) ? &event(m_count - 1) : nullptr;
+  }
+
+private:
+  AlertEvent m_events[kCapacity];
+  size_t     m_head;
+  size_t     m_count;
+  uint32_t   m_total;
+  uint32_t   m_lastReadUs;
+  uint16_t   m_active;
+};
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ina_values.h"
+
+// Long sample history packed into fixed-size blocks. The first sample of a
+// block is stored as is; after that every sample is stored as differences:
+// the timestamp as delta-of-delta (0 at a steady rate) and current, energy
+// and VBUS as deltas, each zig-zag varint coded. A steady signal costs about
+// 5 bytes per sample against the 24 of an unpacked Sample. The oldest block
+// is dropped when all are full, so samples leave in whole blocks.
+//
+// Sequence numbers count add() calls from boot, like MeasurementHistory, so
+// a cursor is valid for both. Reading decodes block by block, oldest first.
+template <size_t kBlockBytes, size_t kBlockCount>
+class CompressedHistory
+{
+public:
+  struct Sample
+  {
+    uint32_t timestampMs;
+    int32_t  current; // ina::CurrentScale
+    uint64_t energy;  // ina::EnergyScale
+    int32_t  vBus;    // ina::BusVoltageScale
+  };
+
+  CompressedHistory()
+      : m_blocks()
+      , m_head(0)
+      , m_used(0)
+      , m_total(0)
+      , m_count(0)
+      , m_last()
+      , m_lastDeltaMs(0)
+  {
+  }
+
+  void add(const InaValues &values, uint32_t timestampMs)
+  {
+    Sample sample;
+    sample.timestampMs = timestampMs;
+    sample.current     = values.current;
+    sample.energy      = values.energy;
+    sample.vBus        = values.vBus;
+
+    uint8_t      packed[kMaxPackedSize];
+    const size_t length = (m_used > 0) ? pack(sample, packed) : 0;
+
+    if (m_used == 0 || openBlock().bytes + length > kDataBytes)
+    {
+      startBlock(sample);
+    }
+    else
+    {
+      Block &block = openBlock();
+      memcpy(block.data + block.bytes, packed, length);
+      block.bytes += static_cast<uint16_t>(length);
+      ++block.count;
+      m_lastDeltaMs = sample.timestampMs - m_last.timestampMs;
+    }
+
+    m_last = sample;
+    ++m_total;
+    ++m_count;
+  }
+
+  size_t count() const
+  {
+    return m_count;
+  }
+
+  uint32_t nextSequence() const
+  {
+    return m_total;
+  }
+
+  uint32_t firstSequence() const
+  {
+    return m_total - static_cast<uint32_t>(m_count);
+  }
+
+  // Same cursor rules as MeasurementHistory::countSince().
+  size_t countSince(uint32_t since) const
+  {
+    const uint32_t pending = m_total - since;
+    if (static_cast<int32_t>(pending) < 0)
+      return m_count;
+    return (pending < m_count) ? pending : m_count;
+  }
+
+  // Visits (sequence, const Sample &) for the retained samples with a sequence
+  // number >= `since`, oldest first. Blocks before the cursor are skipped
+  // without decoding.
+  template <typename Visitor>
+  void forEachSince(uint32_t since, Visitor &&visit) const
+  {
+    const uint32_t first = m_total - static_cast<uint32_t>(countSince(since));
+
+    for (size_t i = 0; i < m_used; ++i)
+    {
+      const Block   &block = m_blocks[(m_head + kBlockCount - m_used + i) % kBlockCount];
+      const uint32_t end   = block.firstSequence + block.count;
+      if (static_cast<int32_t>(end - first) <= 0)
+        continue;
+
+      Sample         sample  = block.first;
+      uint32_t       deltaMs = 0;
+      uint32_t       seq     = block.firstSequence;
+      const uint8_t *p       = block.data;
+      while (true)
+      {
+        if (static_cast<int32_t>(seq - first) >= 0)
+          visit(seq, static_cast<const Sample &>(sample));
+        if (++seq == end)
+          break;
+
+        deltaMs += static_cast<uint32_t>(unzigzag(readVarint(p)));
+        sample.timestampMs += deltaMs;
+        sample.current += static_cast<int32_t>(unzigzag(readVarint(p)));
+        sample.energy += static_cast<uint64_t>(unzigzag(readVarint(p)));
+        sample.vBus += static_cast<int32_t>(unzigzag(readVarint(p)));
+      }
+    }
+  }
+
+  // bytes of packed samples, for comparing with count() * sizeof(Sample)
+  size_t packedBytes() const
+  {
+    size_t bytes = 0;
+    for (size_t i = 0; i < m_used; ++i)
+    {
+      bytes += sizeof(Block) - kDataBytes + m_blocks[(m_head + kBlockCount - m_used + i) % kBlockCount].bytes;
+    }
+    return bytes;
+  }
+
+private:
+  struct Block
+  {
+    Sample   first;
+    uint32_t firstSequence;
+    uint16_t count; // samples including `first`
+    uint16_t bytes; // used bytes of data
+    uint8_t  data[kBlockBytes - sizeof(Sample) - 8];
+  };
+
+  static constexpr size_t kDataBytes     = sizeof(Block::data);
+  static constexpr size_t kMaxPackedSize = 5 + 5 + 10 + 5; // varints of 32, 32, 64 and 32 bits
+
+  static_assert(sizeof(Block) == kBlockBytes, "CompressedHistory block layout");
+  static_assert(sizeof(Sample) == 24, "unpacked Sample size quoted above");
+  static_assert(kDataBytes >= kMaxPackedSize, "CompressedHistory blocks too small");
+  static_assert(kBlockCount >= 2, "CompressedHistory needs two blocks to keep one full");
+
+  Block &openBlock()
+  {
+    return m_blocks[(m_head + kBlockCount - 1) % kBlockCount];
+  }
+
+  // a new block starts from a full sample; the oldest block goes if needed
+  void startBlock(const Sample &sample)
+  {
+    Block &block = m_blocks[m_head];
+    if (m_used == kBlockCount)
+      m_count -= block.count;
+    else
+      ++m_used;
+    m_head = (m_head + 1) % kBlockCount;
+
+    block.first         = sample;
+    block.firstSequence = m_total;
+    block.count         = 1;
+    block.bytes         = 0;
+    m_lastDeltaMs       = 0;
+  }
+
+  size_t pack(const Sample &sample, uint8_t *out) const
+  {
+    const uint32_t deltaMs = sample.timestampMs - m_last.timestampMs;
+
+    uint8_t *p = out;
+    p          = writeVarint(p, zigzag(static_cast<int32_t>(deltaMs - m_lastDeltaMs)));
+    p          = writeVarint(p, zigzag(static_cast<int64_t>(sample.current) - m_last.current));
+    p          = writeVarint(p, zigzag(static_cast<int64_t>(sample.energy - m_last.energy)));
+    p          = writeVarint(p, zigzag(static_cast<int64_t>(sample.vBus) - m_last.vBus));
+    return static_cast<size_t>(p - out);
+  }
+
+  static uint64_t zigzag(int64_t value)
+  {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  }
+
+  static int64_t unzigzag(uint64_t value)
+  {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  static uint8_t *writeVarint(uint8_t *p, uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      *p++ = static_cast<uint8_t>(value | 0x80);
+      value >>= 7;
+    }
+    *p++ = static_cast<uint8_t>(value);
+    return p;
+  }
+
+  static uint64_t readVarint(const uint8_t *&p)
+  {
+    uint64_t value = 0;
+    for (uint8_t shift = 0;; shift += 7)
+    {
+      const uint8_t byte = *p++;
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+        return value;
+    }
+  }
+
+  Block    m_blocks[kBlockCount];
+  size_t   m_head; // next block to start
+  size_t   m_used; // blocks holding samples
+  uint32_t m_total;
+  size_t   m_count;
+  Sample   m_last;
+  uint32_t m_lastDeltaMs;
+};
+
+// The firmware's archive: 4 KB, about 800 samples of a steady load against
+// the 64 of MeasurementHistory.
+class SampleArchive : public CompressedHistory<256, 16>
+{
+};
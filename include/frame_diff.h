@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Sends the parts of a page-organised monochrome framebuffer (one byte = 8
+// vertical pixels, `width` bytes per page) that differ from `shadow`, which
+// holds what the panel currently shows. Changed columns are grouped into runs,
+// merged across gaps of up to `mergeGap` unchanged columns since every run
+// costs a command transaction. sendRun(page, column, data, length) is called
+// per run and the shadow updated; returns the framebuffer bytes sent.
+template <typename SendRun>
+uint16_t flushFrameDiff(const uint8_t *frame, uint8_t *shadow, bool shadowValid, uint16_t width, uint8_t pages,
+                        uint8_t mergeGap, SendRun &&sendRun)
+{
+  uint16_t sent = 0;
+
+  for (uint8_t page = 0; page < pages; ++page)
+  {
+    const uint8_t *pageFrame  = frame + static_cast<uint16_t>(page) * width;
+    uint8_t       *pageShadow = shadow + static_cast<uint16_t>(page) * width;
+
+    int16_t column = 0;
+    while (column < width)
+    {
+      if (shadowValid && pageFrame[column] == pageShadow[column])
+      {
+        ++column;
+        continue;
+      }
+
+      // extend the run until mergeGap unchanged columns in a row
+      int16_t last = column;
+      for (int16_t next = column + 1; next < width && next - last <= mergeGap; ++next)
+      {
+        if (!shadowValid || pageFrame[next] != pageShadow[next])
+        {
+          last = next;
+        }
+      }
+
+      const uint8_t length = static_cast<uint8_t>(last - column + 1);
+      sendRun(page, static_cast<uint8_t>(column), pageFrame + column, length);
+      memcpy(pageShadow + column, pageFrame + column, length);
+      sent  += length;
+      column = last + 1;
+    }
+  }
+
+  return sent;
+}
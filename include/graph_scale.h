@@ -0,0 +1,95 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Autoscaled y range of a graph: the 5th..95th percentile of the plotted
+// values, smoothed over frames, plus a sticky range that jumps to new extremes
+// and only relaxes slowly once it has been held for a while.
+struct GraphScaleState
+{
+  float   min;
+  float   max;
+  float   stickyMin;
+  float   stickyMax;
+  uint8_t holdFrames;
+  bool    initialized;
+  GraphScaleState() : min(0.0f), max(0.0f), stickyMin(0.0f), stickyMax(0.0f), holdFrames(0), initialized(false) {}
+};
+
+constexpr float   kGraphSmoothingAlpha = 0.2f;
+constexpr uint8_t kGraphStickyFrames   = 30;
+constexpr float   kGraphLowQuantile    = 0.05f;
+constexpr float   kGraphHighQuantile   = 0.95f;
+
+// Feeds one frame's kGraphLowQuantile and kGraphHighQuantile of the plotted
+// values, in the units the axis shows. The histories keep these order
+// statistics up to date as samples come and go (see sorted_window.h), so a
+// frame costs the same at any window size.
+inline void updateGraphScale(GraphScaleState &state, float rawMin, float rawMax)
+{
+  if (!state.initialized)
+  {
+    state.min         = rawMin;
+    state.max         = rawMax;
+    state.stickyMin   = rawMin;
+    state.stickyMax   = rawMax;
+    state.holdFrames  = kGraphStickyFrames;
+    state.initialized = true;
+    return;
+  }
+
+  state.min += (rawMin - state.min) * kGraphSmoothingAlpha;
+  state.max += (rawMax - state.max) * kGraphSmoothingAlpha;
+
+  if (rawMin < state.stickyMin || state.holdFrames == 0)
+  {
+    state.stickyMin  = rawMin;
+    state.holdFrames = kGraphStickyFrames;
+  }
+  else if (rawMin > state.stickyMin)
+  {
+    state.stickyMin += (rawMin - state.stickyMin) * (kGraphSmoothingAlpha * 0.5f);
+  }
+
+  if (rawMax > state.stickyMax || state.holdFrames == 0)
+  {
+    state.stickyMax  = rawMax;
+    state.holdFrames = kGraphStickyFrames;
+  }
+  else if (rawMax < state.stickyMax)
+  {
+    state.stickyMax += (rawMax - state.stickyMax) * (kGraphSmoothingAlpha * 0.5f);
+  }
+
+  if (state.holdFrames > 0)
+  {
+    --state.holdFrames;
+  }
+}
+
+// Plot area on the display: x grows to the right from originX, values grow
+// upwards from originY. Both mappings clamp to the area.
+struct GraphAxes
+{
+  int16_t originX;
+  int16_t originY;
+  int16_t width;
+  int16_t height;
+  float   minValue;
+  float   pixelsPerUnit;
+
+  // `relative` position along the x axis, 0..1
+  int16_t x(float relative) const
+  {
+    relative = (relative < 0.0f) ? 0.0f : (relative > 1.0f) ? 1.0f : relative;
+    return originX + static_cast<int16_t>(lroundf(relative * width));
+  }
+
+  int16_t y(float value) const
+  {
+    const long offset = lroundf((value - minValue) * pixelsPerUnit);
+    return originY - static_cast<int16_t>((offset < 0) ? 0 : (offset > height) ? height : offset);
+  }
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bulk transfers on the bus shared with the INA228s, run a step at a time.
+// Each transfer is a step function that moves one bounded piece (a display
+// page, say) per call. runStep() advances the oldest transfer of the highest
+// priority by one step, and the owner calls `done` after the last one.
+//
+// The sensor's register reads are not queued: they are short request and
+// response pairs issued by the acquisition task, which outranks the task that
+// runs the steps. A conversion is therefore served after at most one step,
+// not after a whole transfer.
+class I2cTransferQueue
+{
+public:
+  static constexpr size_t kCapacity = 4;
+
+  enum class Priority : uint8_t
+  {
+    High,
+    Normal,
+    Low
+  };
+
+  // Returns true once the transfer is complete.
+  using StepFunction = bool (*)(void *context);
+  using DoneFunction = void (*)(void *context);
+
+  I2cTransferQueue()
+      : m_transfers()
+      , m_submitted(0)
+  {
+  }
+
+  // False if the queue is full; the caller then has to transfer by itself.
+  bool submit(Priority priority, StepFunction step, DoneFunction done, void *context)
+  {
+    for (Transfer &transfer : m_transfers)
+    {
+      if (transfer.step != nullptr)
+        continue;
+
+      transfer.step     = step;
+      transfer.done     = done;
+      transfer.context  = context;
+      transfer.priority = priority;
+      transfer.order    = m_submitted++;
+      return true;
+    }
+    return false;
+  }
+
+  bool pending() const
+  {
+    for (const Transfer &transfer : m_transfers)
+    {
+      if (transfer.step != nullptr)
+        return true;
+    }
+    return false;
+  }
+
+  // Returns false if nothing was pending.
+  bool runStep()
+  {
+    Transfer *next = nullptr;
+    for (Transfer &transfer : m_transfers)
+    {
+      if (transfer.step == nullptr)
+        continue;
+      if (next == nullptr || transfer.priority < next->priority ||
+          (transfer.priority == next->priority && static_cast<int32_t>(transfer.order - next->order) < 0))
+        next = &transfer;
+    }
+    if (next == nullptr)
+      return false;
+
+    if (next->step(next->context))
+    {
+      // the slot is free before the notification, which may submit again
+      const DoneFunction done    = next->done;
+      void              *context = next->context;
+      next->step                 = nullptr;
+      if (done != nullptr)
+        done(context);
+    }
+    return true;
+  }
+
+private:
+  struct Transfer
+  {
+    StepFunction step     = nullptr; // nullptr = free slot
+    DoneFunction done     = nullptr;
+    void        *context  = nullptr;
+    Priority     priority = Priority::Normal;
+    uint32_t     order    = 0;
+  };
+
+  Transfer m_transfers[kCapacity];
+  uint32_t m_submitted;
+};
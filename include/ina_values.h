@@ -1,10 +1,108 @@
 #pragma once
 
+#include <stdint.h>
+
+namespace detail
+{
+  constexpr double pow10(int exp10)
+  {
+    return (exp10 == 0) ? 1.0 : (exp10 > 0) ? 10.0 * pow10(exp10 - 1) : 0.1 * pow10(exp10 + 1);
+  }
+}
+
+// Compile-time scale of a raw LSB count: value = raw * Num / Den * 10^Exp10 (base unit).
+// Samples stay integer through acquisition, history and statistics; toFloat()
+// is meant for the presentation edge only.
+template <int64_t Num, int64_t Den, int Exp10>
+struct FixedScale
+{
+  static constexpr int64_t kNum    = Num;
+  static constexpr int64_t kDen    = Den;
+  static constexpr int     kExp10  = Exp10;
+  static constexpr float   kFactor = static_cast<float>(detail::pow10(Exp10) * Num / Den);
+
+  static float toFloat(int64_t raw)
+  {
+    return static_cast<float>(raw) * kFactor;
+  }
+};
+
+namespace ina
+{
+  constexpr double kShuntOhms   = 0.05;
+  constexpr bool   kLowAdcRange = true; // ADCRANGE = 1 (+-40.96 mV)
+
+  // CURRENT LSB = full scale / 2^19, with SHUNT_CAL programmed to match
+  constexpr double  kCurrentLsbA  = ((kLowAdcRange ? 0.04096 : 0.16384) / kShuntOhms) / 524288.0;
+  constexpr int64_t kCurrentLsbPa = static_cast<int64_t>(kCurrentLsbA * 1e12 + 0.5);
+  constexpr int64_t kEnergyLsbNj  = static_cast<int64_t>(16.0 * 3.2 * kCurrentLsbA * 1e9 + 0.5);
+
+  using ShuntVoltageScale = FixedScale<kLowAdcRange ? 78125 : 312500, 1, -12>; // V
+  using BusVoltageScale   = FixedScale<1953125, 1, -10>;                        // V
+  using DieTempScale      = FixedScale<78125, 1, -7>;                           // degC
+  using CurrentScale      = FixedScale<kCurrentLsbPa, 1, -12>;                  // A
+  using ChargeScale       = FixedScale<kCurrentLsbPa, 1, -12>;                  // C
+  using EnergyScale       = FixedScale<kEnergyLsbNj, 1, -9>;                    // Ws
+  using EnergyWhScale     = FixedScale<kEnergyLsbNj, 3600, -9>;                 // Wh
+
+  // DIAG_ALRT flags. The limit flags are compared against every conversion
+  // (SLOWALERT = 0), not only against the averaged result.
+  constexpr uint16_t kDiagTempOver       = 1 << 7; // TMPOL
+  constexpr uint16_t kDiagShuntOver      = 1 << 6; // SHNTOL
+  constexpr uint16_t kDiagShuntUnder     = 1 << 5; // SHNTUL
+  constexpr uint16_t kDiagBusOver        = 1 << 4; // BUSOL
+  constexpr uint16_t kDiagBusUnder       = 1 << 3; // BUSUL
+  constexpr uint16_t kDiagPowerOver      = 1 << 2; // POL
+  constexpr uint16_t kDiagConversionDone = 1 << 1; // CNVRF, cleared by reading DIAG_ALRT
+  constexpr uint16_t kDiagLimitMask      = kDiagTempOver | kDiagShuntOver | kDiagShuntUnder | kDiagBusOver | kDiagBusUnder | kDiagPowerOver;
+
+  // Limit register LSBs: SOVL/SUVL, BOVL/BUVL, PWR_LIMIT, TEMP_LIMIT
+  constexpr double kShuntLimitLsbV = kLowAdcRange ? 1.25e-6 : 5e-6;
+  constexpr double kBusLimitLsbV   = 3.125e-3;
+  constexpr double kPowerLimitLsbW = 256.0 * 3.2 * kCurrentLsbA;
+  constexpr double kTempLimitLsbC  = 7.8125e-3;
+
+  // Raw codes for the limit registers; the defaults are the power-on values,
+  // which never trip.
+  struct AlertLimits
+  {
+    int16_t  shuntOver  = 0x7FFF;
+    int16_t  shuntUnder = -0x8000;
+    uint16_t busOver    = 0x7FFF;
+    uint16_t busUnder   = 0;
+    uint16_t powerOver  = 0xFFFF;
+    int16_t  tempOver   = 0x7FFF;
+  };
+
+  // current through the shunt, may be negative
+  constexpr int16_t shuntLimitCode(double amps)
+  {
+    return static_cast<int16_t>(amps * kShuntOhms / kShuntLimitLsbV + (amps < 0.0 ? -0.5 : 0.5));
+  }
+
+  constexpr uint16_t busLimitCode(double volts)
+  {
+    return static_cast<uint16_t>(volts / kBusLimitLsbV + 0.5);
+  }
+
+  constexpr uint16_t powerLimitCode(double watts)
+  {
+    return static_cast<uint16_t>(watts / kPowerLimitLsbW + 0.5);
+  }
+
+  constexpr int16_t tempLimitCode(double celsius)
+  {
+    return static_cast<int16_t>(celsius / kTempLimitLsbC + (celsius < 0.0 ? -0.5 : 0.5));
+  }
+}
+
+// One INA228 conversion as raw register codes (LSB counts).
 struct InaValues
 {
-  float vShunt;
-  float vBus;
-  float temperature;
-  float current_mA;
-  float energyWs;
+  int32_t  vShunt;  // ina::ShuntVoltageScale
+  int32_t  vBus;    // ina::BusVoltageScale
+  int16_t  dieTemp; // ina::DieTempScale
+  int32_t  current; // ina::CurrentScale
+  uint64_t energy;  // ina::EnergyScale
+  int64_t  charge;  // ina::ChargeScale
 };
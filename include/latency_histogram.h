@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-bucket histogram of durations in microseconds, laid out like a
+// Prometheus histogram: bucket i counts the durations up to kBoundsUs[i], the
+// extra last bucket everything longer. add() is a short scan, no division.
+class LatencyHistogram
+{
+public:
+  static constexpr size_t kBoundCount = 12;
+
+  static constexpr uint32_t kBoundsUs[kBoundCount] = {
+      50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000,
+  };
+
+  static constexpr size_t kBucketCount = kBoundCount + 1;
+
+  LatencyHistogram()
+      : m_buckets()
+      , m_count(0)
+      , m_sumUs(0)
+      , m_maxUs(0)
+  {
+  }
+
+  void add(uint32_t us)
+  {
+    size_t bucket = 0;
+    while (bucket < kBoundCount && us > kBoundsUs[bucket])
+    {
+      ++bucket;
+    }
+
+    ++m_buckets[bucket];
+    ++m_count;
+    m_sumUs += us;
+    if (us > m_maxUs)
+      m_maxUs = us;
+  }
+
+  // not cumulative, kBucketCount entries
+  uint32_t bucket(size_t index) const
+  {
+    return m_buckets[index];
+  }
+
+  uint32_t count() const
+  {
+    return m_count;
+  }
+
+  uint64_t sumUs() const
+  {
+    return m_sumUs;
+  }
+
+  uint32_t maxUs() const
+  {
+    return m_maxUs;
+  }
+
+private:
+  uint32_t m_buckets[kBucketCount];
+  uint32_t m_count;
+  uint64_t m_sumUs;
+  uint32_t m_maxUs;
+};
@@ -1,50 +1,163 @@
 #pragma once
 
+#include <math.h>
 #include <stddef.h>
+#include <stdint.h>
 
-class MeasurementHistory
+#include "ina_values.h"
+#include "ring_view.h"
+#include "sorted_window.h"
+
+// Extra per-sample channels for BasicMeasurementHistory. A channel picks its
+// raw value out of InaValues and sets the storage type, so narrow registers
+// and quantised values don't cost 32 bits per sample.
+namespace history
+{
+  struct BusVoltage
+  {
+    using Type = int32_t; // ina::BusVoltageScale
+    static Type sample(const InaValues &values)
+    {
+      return values.vBus;
+    }
+  };
+
+  struct ShuntVoltage
+  {
+    using Type = int32_t; // ina::ShuntVoltageScale
+    static Type sample(const InaValues &values)
+    {
+      return values.vShunt;
+    }
+  };
+
+  struct DieTemp
+  {
+    using Type = int16_t; // ina::DieTempScale
+    static Type sample(const InaValues &values)
+    {
+      return values.dieTemp;
+    }
+  };
+
+  // VBUS without its 4 lowest bits: 3.125 mV steps, still the full 0..85 V
+  struct BusVoltageCoarse
+  {
+    using Type = uint16_t; // 16 * ina::BusVoltageScale
+    static Type sample(const InaValues &values)
+    {
+      return static_cast<Type>((values.vBus < 0) ? 0 : values.vBus >> 4);
+    }
+  };
+}
+
+// Ring of the most recent samples in raw INA228 units: CURRENT LSB counts,
+// ENERGY register counts and milliseconds since boot, plus the `Channels`
+// listed (see namespace history). The capacity is a power of two so the ring
+// indices wrap with a mask.
+//
+// Only the extra channels choose their storage type. Current stays int32_t:
+// the window sums, the min/max queues and the quantiles are exact on the
+// 20-bit codes, and the display and web code format them with CurrentScale.
+// Energy and timestamps keep the register and millis() widths.
+template <size_t kCapacityValue, typename... Channels>
+class BasicMeasurementHistory
 {
 public:
-  static constexpr size_t kCapacity = 64;
+  static constexpr size_t kCapacity = kCapacityValue;
+  static constexpr size_t kMask     = kCapacity - 1;
+
+  static_assert(kCapacity >= 2 && (kCapacity & kMask) == 0, "MeasurementHistory capacity must be a power of two");
+
+  // n * sum(x^2) must fit 64 bits for 20-bit CURRENT codes
+  static_assert(kCapacity <= 4096, "MeasurementHistory capacity too large for exact integer variance");
 
-  MeasurementHistory()
+  BasicMeasurementHistory()
       : m_count(0)
       , m_head(0)
+      , m_total(0)
+      , m_sum(0)
+      , m_sumSquares(0)
+      , m_channels()
   {
     for (size_t i = 0; i < kCapacity; ++i)
     {
-      m_current[i]   = 0.0f;
-      m_energy[i]    = 0.0f;
-      m_timestamp[i] = 0.0f;
+      m_current[i]   = 0;
+      m_energy[i]    = 0;
+      m_timestamp[i] = 0;
     }
   }
 
-  void addMeasurement(float current_mA, float energyWs, float timestampSeconds)
+  // The extra channels are only filled by this overload.
+  void addMeasurement(const InaValues &values, uint32_t timestampMs)
+  {
+    (store<Channels>(values), ...);
+    addMeasurement(values.current, values.energy, timestampMs);
+  }
+
+  void addMeasurement(int32_t current, uint64_t energy, uint32_t timestampMs)
   {
-    m_current[m_head]   = current_mA;
-    m_energy[m_head]    = energyWs;
-    m_timestamp[m_head] = timestampSeconds;
+    const bool     full          = (m_count == kCapacity);
+    const int32_t  evicted       = m_current[m_head];
+    const uint64_t evictedEnergy = m_energy[m_head];
 
-    m_head = (m_head + 1) % kCapacity;
+    m_current[m_head]   = current;
+    m_energy[m_head]    = energy;
+    m_timestamp[m_head] = timestampMs;
+
+    m_head = (m_head + 1) & kMask;
     if (m_count < kCapacity)
     {
       ++m_count;
     }
+
+    updateStats(current, evicted, full);
+
+    if (full)
+    {
+      m_sortedCurrent.replace(evicted, current);
+      m_sortedEnergy.replace(evictedEnergy, energy);
+    }
+    else
+    {
+      m_sortedCurrent.insert(current);
+      m_sortedEnergy.insert(energy);
+    }
+  }
+
+  RingView<int32_t> currents() const
+  {
+    return RingView<int32_t>::fromRing(m_current, kCapacity, m_head, m_count);
+  }
+
+  RingView<uint64_t> energy() const
+  {
+    return RingView<uint64_t>::fromRing(m_energy, kCapacity, m_head, m_count);
   }
 
-  size_t copyCurrents(float *dest, size_t maxCount) const
+  RingView<uint32_t> timestamps() const
   {
-    return copyBuffer(m_current, dest, maxCount);
+    return RingView<uint32_t>::fromRing(m_timestamp, kCapacity, m_head, m_count);
   }
 
-  size_t copyEnergy(float *dest, size_t maxCount) const
+  // Ring of one of the extra channels, same order as currents().
+  template <typename Channel>
+  RingView<typename Channel::Type> channel() const
   {
-    return copyBuffer(m_energy, dest, maxCount);
+    return RingView<typename Channel::Type>::fromRing(static_cast<const ChannelRing<Channel> &>(m_channels).values, kCapacity,
+                                                      m_head, m_count);
   }
 
-  size_t copyTimestamps(float *dest, size_t maxCount) const
+  // Visits (current, energy, timestampMs) oldest first without copying.
+  template <typename Visitor>
+  void forEachSample(Visitor &&visit) const
   {
-    return copyBuffer(m_timestamp, dest, maxCount);
+    const size_t start = (m_head - m_count) & kMask;
+    for (size_t i = 0; i < m_count; ++i)
+    {
+      const size_t index = (start + i) & kMask;
+      visit(m_current[index], m_energy[index], m_timestamp[index]);
+    }
   }
 
   size_t count() const
@@ -52,73 +165,215 @@ public:
     return m_count;
   }
 
+  // Every sample gets a sequence number, counting from 0 at boot; the ring
+  // holds [firstSequence(), nextSequence()).
+  uint32_t nextSequence() const
+  {
+    return m_total;
+  }
+
+  uint32_t firstSequence() const
+  {
+    return m_total - static_cast<uint32_t>(m_count);
+  }
+
+  // Number of retained samples with a sequence number >= `since`. A cursor
+  // ahead of nextSequence() (the meter rebooted) gets the whole ring.
+  size_t countSince(uint32_t since) const
+  {
+    const uint32_t pending = m_total - since;
+    if (static_cast<int32_t>(pending) < 0)
+      return m_count;
+    return (pending < m_count) ? pending : m_count;
+  }
+
+  // Visits (sequence, current, energy, timestampMs) for the retained samples
+  // with a sequence number >= `since`, oldest first. Samples that already
+  // left the ring are skipped; the caller sees the gap in the sequence.
+  template <typename Visitor>
+  void forEachSince(uint32_t since, Visitor &&visit) const
+  {
+    const size_t pending = countSince(since);
+    size_t       index   = (m_head - pending) & kMask;
+    uint32_t     seq     = m_total - static_cast<uint32_t>(pending);
+    for (size_t i = 0; i < pending; ++i)
+    {
+      visit(seq++, m_current[index], m_energy[index], m_timestamp[index]);
+      index = (index + 1) & kMask;
+    }
+  }
+
+  // All values in CURRENT LSB counts.
   struct CurrentStats
   {
-    float minCurrent;
-    float maxCurrent;
-    float meanCurrent;
-    float stdDeviation;
+    int32_t minCurrent;
+    int32_t maxCurrent;
+    float   meanCurrent;
+    float   stdDeviation;
   };
 
+  // O(1): the window sums are maintained exactly in integers by addMeasurement(),
+  // only the final division and square root are done in float.
   CurrentStats getCurrentStats() const
   {
-    CurrentStats stats = {0.0f, 0.0f, 0.0f, 0.0f};
+    CurrentStats stats = {0, 0, 0.0f, 0.0f};
 
     if (m_count == 0)
       return stats;
 
-    // First pass: compute min, max, and mean
-    float minVal = m_current[0];
-    float maxVal = m_current[0];
-    float sum    = m_current[0];
+    const int64_t n = static_cast<int64_t>(m_count);
+
+    stats.minCurrent  = m_minQueue.front();
+    stats.maxCurrent  = m_maxQueue.front();
+    stats.meanCurrent = static_cast<float>(m_sum) / static_cast<float>(n);
 
-    for (size_t i = 1; i < m_count; ++i)
+    if (m_count >= 2)
     {
-      const float val = m_current[i];
+      // n^2 * variance = n * sum(x^2) - sum(x)^2, exact and never negative
+      const uint64_t absSum  = static_cast<uint64_t>(m_sum < 0 ? -m_sum : m_sum);
+      const uint64_t scaled  = static_cast<uint64_t>(n) * m_sumSquares - absSum * absSum;
+      stats.stdDeviation     = sqrtf(static_cast<float>(scaled)) / static_cast<float>(n);
+    }
 
-      if (val < minVal) minVal = val;
-      if (val > maxVal) maxVal = val;
+    return stats;
+  }
+
+  // Order statistics of the window, e.g. 0.05 for the 5th percentile; O(1).
+  // Only meaningful while count() > 0.
+  int32_t currentQuantile(float q) const
+  {
+    return m_sortedCurrent.quantile(q);
+  }
+
+  uint64_t energyQuantile(float q) const
+  {
+    return m_sortedEnergy.quantile(q);
+  }
 
-      sum += val;
+private:
+  // Monotonic deque over the sliding window: the front always holds the window
+  // minimum (or maximum), every sample is pushed and popped at most once.
+  template <bool kKeepMax>
+  class MonotonicQueue
+  {
+  public:
+    MonotonicQueue()
+        : m_first(0)
+        , m_size(0)
+    {
     }
 
-    stats.minCurrent  = minVal;
-    stats.maxCurrent  = maxVal;
-    stats.meanCurrent = sum / static_cast<float>(m_count);
+    void push(int32_t value, uint32_t seq)
+    {
+      while (m_size > 0 && dominates(value, m_entries[backIndex()].value))
+      {
+        --m_size;
+      }
 
-    // Second pass: compute variance using numerically stable method
-    if (m_count >= 2)
+      Entry &entry = m_entries[(m_first + m_size) & kMask];
+      entry.value  = value;
+      entry.seq    = seq;
+      ++m_size;
+    }
+
+    void expire(uint32_t oldestSeq)
     {
-      float varianceSum = 0.0f;
-      for (size_t i = 0; i < m_count; ++i)
+      while (m_size > 0 && static_cast<int32_t>(m_entries[m_first].seq - oldestSeq) < 0)
       {
-        const float diff = m_current[i] - stats.meanCurrent;
-        varianceSum += diff * diff;
+        m_first = (m_first + 1) & kMask;
+        --m_size;
       }
-      const float variance = varianceSum / static_cast<float>(m_count);
-      stats.stdDeviation = sqrt(variance > 0.0f ? variance : 0.0f);
     }
 
-    return stats;
+    int32_t front() const
+    {
+      return m_entries[m_first].value;
+    }
+
+  private:
+    struct Entry
+    {
+      int32_t  value;
+      uint32_t seq;
+    };
+
+    static bool dominates(int32_t candidate, int32_t existing)
+    {
+      return kKeepMax ? (candidate >= existing) : (candidate <= existing);
+    }
+
+    size_t backIndex() const
+    {
+      return (m_first + m_size - 1) & kMask;
+    }
+
+    Entry  m_entries[kCapacity];
+    size_t m_first;
+    size_t m_size;
+  };
+
+  template <typename Channel>
+  struct ChannelRing
+  {
+    typename Channel::Type values[kCapacity];
+  };
+
+  struct ChannelRings : ChannelRing<Channels>...
+  {
+  };
+
+  template <typename Channel>
+  void store(const InaValues &values)
+  {
+    static_cast<ChannelRing<Channel> &>(m_channels).values[m_head] = Channel::sample(values);
   }
 
-private:
-  size_t copyBuffer(const float *src, float *dest, size_t maxCount) const
+  void updateStats(int32_t value, int32_t evicted, bool replaced)
   {
-    const size_t toCopy = (m_count < maxCount) ? m_count : maxCount;
+    const int64_t square = static_cast<int64_t>(value) * value;
+
+    m_sum        += value;
+    m_sumSquares += static_cast<uint64_t>(square);
 
-    for (size_t i = 0; i < toCopy; ++i)
+    if (replaced)
     {
-      const size_t index = (m_head + kCapacity - toCopy + i) % kCapacity;
-      dest[i]            = src[index];
+      m_sum        -= evicted;
+      m_sumSquares -= static_cast<uint64_t>(static_cast<int64_t>(evicted) * evicted);
     }
 
-    return toCopy;
+    const uint32_t seq       = m_total++;
+    const uint32_t oldestSeq = m_total - static_cast<uint32_t>(m_count);
+
+    // expire first: with a full window the evicted entry still occupies the
+    // slot the push would write
+    m_minQueue.expire(oldestSeq);
+    m_maxQueue.expire(oldestSeq);
+    m_minQueue.push(value, seq);
+    m_maxQueue.push(value, seq);
   }
 
-  float  m_current[kCapacity];
-  float  m_energy[kCapacity];
-  float  m_timestamp[kCapacity];
-  size_t m_count;
-  size_t m_head;
+  int32_t               m_current[kCapacity];
+  uint64_t              m_energy[kCapacity];
+  uint32_t              m_timestamp[kCapacity];
+  size_t                m_count;
+  size_t                m_head;
+  uint32_t              m_total;
+  int64_t               m_sum;
+  uint64_t              m_sumSquares;
+  MonotonicQueue<false> m_minQueue;
+  MonotonicQueue<true>  m_maxQueue;
+
+  SortedWindow<int32_t, kCapacity>  m_sortedCurrent;
+  SortedWindow<uint64_t, kCapacity> m_sortedEnergy;
+  ChannelRings                      m_channels;
+};
+
+#ifndef MEASUREMENT_HISTORY_CAPACITY
+#define MEASUREMENT_HISTORY_CAPACITY 64
+#endif
+
+// The firmware's history. The capacity can be set per build with
+// -D MEASUREMENT_HISTORY_CAPACITY=<power of two>.
+class MeasurementHistory : public BasicMeasurementHistory<MEASUREMENT_HISTORY_CAPACITY, history::BusVoltage>
+{
 };
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <stddef.h>
+
+// Read-only, non-owning view over the filled part of a ring buffer.
+// The entries are exposed oldest first as (at most) two contiguous segments,
+// so consumers can iterate in place instead of copying the ring out.
+template <typename T>
+class RingView
+{
+public:
+  class Iterator
+  {
+  public:
+    Iterator(const RingView *view, size_t index)
+        : m_view(view)
+        , m_index(index)
+    {
+    }
+
+    const T &operator*() const
+    {
+      return (*m_view)[m_index];
+    }
+
+    Iterator &operator++()
+    {
+      ++m_index;
+      return *this;
+    }
+
+    bool operator!=(const Iterator &other) const
+    {
+      return m_index != other.m_index;
+    }
+
+  private:
+    const RingView *m_view;
+    size_t          m_index;
+  };
+
+  RingView()
+      : m_first(nullptr)
+      , m_firstCount(0)
+      , m_second(nullptr)
+      , m_secondCount(0)
+  {
+  }
+
+  RingView(const T *first, size_t firstCount, const T *second, size_t secondCount)
+      : m_first(first)
+      , m_firstCount(firstCount)
+      , m_second(second)
+      , m_secondCount(secondCount)
+  {
+  }
+
+  // View over the `count` newest entries of a ring whose next write slot is `head`.
+  static RingView fromRing(const T *buffer, size_t capacity, size_t head, size_t count)
+  {
+    const size_t start      = (head + capacity - count) % capacity;
+    const size_t firstCount = (count < capacity - start) ? count : capacity - start;
+    return RingView(buffer + start, firstCount, buffer, count - firstCount);
+  }
+
+  size_t size() const
+  {
+    return m_firstCount + m_secondCount;
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  const T &operator[](size_t index) const
+  {
+    return (index < m_firstCount) ? m_first[index] : m_second[index - m_firstCount];
+  }
+
+  const T &front() const
+  {
+    return (*this)[0];
+  }
+
+  const T &back() const
+  {
+    return (*this)[size() - 1];
+  }
+
+  // The newest `count` entries.
+  RingView newest(size_t count) const
+  {
+    if (count >= size())
+      return *this;
+
+    const size_t skip = size() - count;
+    if (skip >= m_firstCount)
+      return RingView(m_second + (skip - m_firstCount), count, nullptr, 0);
+
+    return RingView(m_first + skip, m_firstCount - skip, m_second, m_secondCount);
+  }
+
+  const T *firstSegment() const  { return m_first; }
+  size_t   firstCount() const    { return m_firstCount; }
+  const T *secondSegment() const { return m_second; }
+  size_t   secondCount() const   { return m_secondCount; }
+
+  Iterator begin() const
+  {
+    return Iterator(this, 0);
+  }
+
+  Iterator end() const
+  {
+    return Iterator(this, size());
+  }
+
+  // Visits every entry oldest first, one tight loop per segment.
+  template <typename Visitor>
+  void forEach(Visitor &&visit) const
+  {
+    for (size_t i = 0; i < m_firstCount; ++i)
+      visit(m_first[i]);
+    for (size_t i = 0; i < m_secondCount; ++i)
+      visit(m_second[i]);
+  }
+
+private:
+  const T *m_first;
+  size_t   m_firstCount;
+  const T *m_second;
+  size_t   m_secondCount;
+};
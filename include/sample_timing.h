@@ -0,0 +1,173 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "latency_histogram.h"
+
+// Timestamps of the ALERT edges, written by the interrupt and read by the main
+// loop. Single producer, single consumer: both only ever advance their own
+// counter, so neither side has to disable interrupts. When the loop falls
+// more than kCapacity edges behind, the oldest stamps are overwritten and
+// drain() reports them as lost.
+template <size_t kCapacity>
+class EdgeTimestampRing
+{
+public:
+  static constexpr size_t kMask = kCapacity - 1;
+
+  static_assert(kCapacity >= 2 && (kCapacity & kMask) == 0, "EdgeTimestampRing capacity must be a power of two");
+
+  EdgeTimestampRing()
+      : m_stamps()
+      , m_written(0)
+      , m_read(0)
+  {
+  }
+
+  // Interrupt side; inlined so it stays in the ISR's IRAM.
+  __attribute__((always_inline)) void push(uint32_t timestampUs)
+  {
+    const uint32_t written    = m_written;
+    m_stamps[written & kMask] = timestampUs;
+    m_written                 = written + 1;
+  }
+
+  bool pending() const
+  {
+    return m_written != m_read;
+  }
+
+  // Reports the overwritten stamps to `lost` (before any retained one, as they
+  // are older), then visits the retained stamps oldest first. Returns the
+  // number of edges since the last call, including overwritten ones.
+  template <typename LossHandler, typename Visitor>
+  uint32_t drain(LossHandler &&lost, Visitor &&visit)
+  {
+    const uint32_t written = m_written;
+    const uint32_t edges   = written - m_read;
+    const uint32_t first   = (edges > kCapacity) ? written - kCapacity : m_read;
+    if (first != m_read)
+    {
+      lost(first - m_read);
+    }
+    for (uint32_t i = first; i != written; ++i)
+    {
+      visit(m_stamps[i & kMask]);
+    }
+    m_read = written;
+    return edges;
+  }
+
+  // Forgets pending edges, e.g. those raised by a burst capture.
+  void discard()
+  {
+    m_read = m_written;
+  }
+
+private:
+  volatile uint32_t m_stamps[kCapacity];
+  volatile uint32_t m_written;
+  uint32_t          m_read;
+};
+
+// Accounting of the conversion timing as seen through the ALERT edges:
+// conversions that were overwritten before they were read, the delay from
+// the edge to the register read, and the jitter between edge intervals.
+class SampleTiming
+{
+public:
+  SampleTiming()
+      : m_edges(0)
+      , m_dropped(0)
+      , m_lostStamps(0)
+      , m_lastEdgeUs(0)
+      , m_lastIntervalUs(0)
+      , m_chain(0)
+      , m_latency()
+      , m_jitter()
+  {
+  }
+
+  // Every edge stamp, oldest first.
+  void addEdge(uint32_t timestampUs)
+  {
+    ++m_edges;
+    if (m_chain >= 1)
+    {
+      const uint32_t interval = timestampUs - m_lastEdgeUs;
+      if (m_chain >= 2)
+        m_jitter.add((interval > m_lastIntervalUs) ? interval - m_lastIntervalUs : m_lastIntervalUs - interval);
+      m_lastIntervalUs = interval;
+    }
+    m_lastEdgeUs = timestampUs;
+    if (m_chain < 2)
+      ++m_chain;
+  }
+
+  // Edges whose stamp was overwritten; the interval chain restarts.
+  void addLostStamps(uint32_t count)
+  {
+    m_lostStamps += count;
+    m_edges += count;
+    m_chain = 0;
+  }
+
+  // One register read that served `edges` conversion edges, `latencyUs` after
+  // the newest one. The INA228 keeps only the latest result, so all but one
+  // of the conversions are gone.
+  void addService(uint32_t edges, uint32_t latencyUs)
+  {
+    if (edges > 1)
+      m_dropped += edges - 1;
+    m_latency.add(latencyUs);
+  }
+
+  // A stretch without edge timing (burst capture); intervals restart.
+  void restart()
+  {
+    m_chain = 0;
+  }
+
+  uint32_t edges() const
+  {
+    return m_edges;
+  }
+
+  uint32_t droppedConversions() const
+  {
+    return m_dropped;
+  }
+
+  uint32_t lostStamps() const
+  {
+    return m_lostStamps;
+  }
+
+  uint32_t lastIntervalUs() const
+  {
+    return m_lastIntervalUs;
+  }
+
+  // edge -> register read
+  const LatencyHistogram &serviceLatency() const
+  {
+    return m_latency;
+  }
+
+  // |interval - previous interval| between consecutive edges
+  const LatencyHistogram &intervalJitter() const
+  {
+    return m_jitter;
+  }
+
+private:
+  uint32_t         m_edges;
+  uint32_t         m_dropped;
+  uint32_t         m_lostStamps;
+  uint32_t         m_lastEdgeUs;
+  uint32_t         m_lastIntervalUs;
+  uint8_t          m_chain; // consecutive stamps seen, up to 2
+  LatencyHistogram m_latency;
+  LatencyHistogram m_jitter;
+};
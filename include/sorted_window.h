@@ -0,0 +1,127 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+// Rank of the q-quantile (0..1) among `count` sorted values, nearest rank.
+inline size_t quantileRank(float q, size_t count)
+{
+  if (count == 0)
+    return 0;
+  const float rank = roundf(q * static_cast<float>(count - 1));
+  return (rank <= 0.0f) ? 0 : (rank >= count - 1) ? count - 1 : static_cast<size_t>(rank);
+}
+
+// The values of a sliding window kept in sorted order, so every order
+// statistic is a lookup. The owner of the window reports each value as it
+// enters and leaves. A slot is found by binary search and the entries in
+// between are moved with one memmove: contiguous storage keeps that cheaper
+// than a balanced tree up to thousands of entries, with no per-node memory.
+template <typename T, size_t kCapacity>
+class SortedWindow
+{
+public:
+  SortedWindow()
+      : m_values()
+      , m_size(0)
+  {
+  }
+
+  bool insert(T value)
+  {
+    if (m_size == kCapacity)
+      return false;
+
+    const size_t slot = lowerBound(value);
+    memmove(&m_values[slot + 1], &m_values[slot], (m_size - slot) * sizeof(T));
+    m_values[slot] = value;
+    ++m_size;
+    return true;
+  }
+
+  bool erase(T value)
+  {
+    const size_t slot = lowerBound(value);
+    if (slot == m_size || m_values[slot] != value)
+      return false;
+
+    memmove(&m_values[slot], &m_values[slot + 1], (m_size - slot - 1) * sizeof(T));
+    --m_size;
+    return true;
+  }
+
+  // erase(oldValue) and insert(newValue) in one pass; only the entries
+  // between the two slots move.
+  void replace(T oldValue, T newValue)
+  {
+    const size_t from = lowerBound(oldValue);
+    if (from == m_size || m_values[from] != oldValue)
+    {
+      insert(newValue);
+      return;
+    }
+
+    size_t to = lowerBound(newValue);
+    if (to > from)
+    {
+      --to;
+      memmove(&m_values[from], &m_values[from + 1], (to - from) * sizeof(T));
+    }
+    else
+    {
+      memmove(&m_values[to + 1], &m_values[to], (from - to) * sizeof(T));
+    }
+    m_values[to] = newValue;
+  }
+
+  void clear()
+  {
+    m_size = 0;
+  }
+
+  size_t size() const
+  {
+    return m_size;
+  }
+
+  // 0 = smallest; size() must not be 0
+  T at(size_t rank) const
+  {
+    return m_values[rank];
+  }
+
+  T quantile(float q) const
+  {
+    return m_values[quantileRank(q, m_size)];
+  }
+
+  // Quantile of the window plus one value that is not stored, such as a
+  // bucket still being filled.
+  T quantileWith(T extra, float q) const
+  {
+    const size_t rank = quantileRank(q, m_size + 1);
+    const size_t slot = lowerBound(extra);
+    return (rank < slot) ? m_values[rank] : (rank == slot) ? extra : m_values[rank - 1];
+  }
+
+private:
+  // first slot whose value is not less than `value`
+  size_t lowerBound(T value) const
+  {
+    size_t first = 0;
+    size_t last  = m_size;
+    while (first < last)
+    {
+      const size_t middle = first + (last - first) / 2;
+      if (m_values[middle] < value)
+        first = middle + 1;
+      else
+        last = middle;
+    }
+    return first;
+  }
+
+  T      m_values[kCapacity];
+  size_t m_size;
+};
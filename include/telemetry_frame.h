@@ -0,0 +1,186 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ina_values.h"
+
+// Binary sample frames for the serial link, shared by the firmware and the
+// host decoder (src/telemetry_decoder.cpp).
+//
+// On the wire: COBS(payload, CRC) followed by a 0x00 delimiter, so a receiver
+// resynchronises at the next zero byte after any corruption.
+//
+// Payload, little-endian:
+//   u8  type (kSampleType)
+//   u32 sequence     sample number since boot, gaps are lost frames
+//   u32 timestamp    microseconds since boot
+//   i32 vShunt, i32 vBus, i32 current, i16 dieTemp
+//   u40 energy, i40 charge
+//   u16 CRC-16/CCITT-FALSE over everything above
+namespace telemetry
+{
+  constexpr uint8_t kSampleType        = 1;
+  constexpr size_t  kSamplePayloadSize = 1 + 4 + 4 + 4 + 4 + 4 + 2 + 5 + 5;
+  constexpr size_t  kCrcSize           = 2;
+  constexpr size_t  kMaxFrameSize      = (kSamplePayloadSize + kCrcSize) + 1 + 1; // COBS overhead + delimiter
+
+  struct Sample
+  {
+    uint32_t  sequence;
+    uint32_t  timestampUs;
+    InaValues values;
+  };
+
+  inline uint16_t crc16(const uint8_t *data, size_t length)
+  {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; ++i)
+    {
+      crc ^= static_cast<uint16_t>(data[i]) << 8;
+      for (uint8_t bit = 0; bit < 8; ++bit)
+      {
+        crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+      }
+    }
+    return crc;
+  }
+
+  // `out` needs length + length / 254 + 1 bytes; returns the encoded size.
+  inline size_t cobsEncode(const uint8_t *in, size_t length, uint8_t *out)
+  {
+    size_t codeIndex = 0;
+    size_t outIndex  = 1;
+    uint8_t code     = 1;
+
+    for (size_t i = 0; i < length; ++i)
+    {
+      if (in[i] != 0)
+      {
+        out[outIndex++] = in[i];
+        ++code;
+      }
+      if (in[i] == 0 || code == 0xFF)
+      {
+        out[codeIndex] = code;
+        codeIndex      = outIndex++;
+        code           = 1;
+      }
+    }
+    out[codeIndex] = code;
+    return outIndex;
+  }
+
+  // Returns the decoded size, or 0 for malformed input.
+  inline size_t cobsDecode(const uint8_t *in, size_t length, uint8_t *out, size_t size)
+  {
+    size_t inIndex  = 0;
+    size_t outIndex = 0;
+
+    while (inIndex < length)
+    {
+      const uint8_t code = in[inIndex++];
+      if (code == 0 || inIndex + code - 1 > length)
+      {
+        return 0;
+      }
+      for (uint8_t i = 1; i < code; ++i)
+      {
+        if (outIndex >= size)
+          return 0;
+        out[outIndex++] = in[inIndex++];
+      }
+      if (code != 0xFF && inIndex < length)
+      {
+        if (outIndex >= size)
+          return 0;
+        out[outIndex++] = 0;
+      }
+    }
+    return outIndex;
+  }
+
+  namespace detail
+  {
+    inline uint8_t *putLittleEndian(uint8_t *p, uint64_t value, uint8_t bytes)
+    {
+      for (uint8_t i = 0; i < bytes; ++i)
+      {
+        *p++ = static_cast<uint8_t>(value >> (8 * i));
+      }
+      return p;
+    }
+
+    inline uint64_t getLittleEndian(const uint8_t *&p, uint8_t bytes)
+    {
+      uint64_t value = 0;
+      for (uint8_t i = 0; i < bytes; ++i)
+      {
+        value |= static_cast<uint64_t>(*p++) << (8 * i);
+      }
+      return value;
+    }
+
+    inline int64_t signExtend(uint64_t value, uint8_t bits)
+    {
+      const uint64_t sign = 1ULL << (bits - 1);
+      return static_cast<int64_t>((value ^ sign) - sign);
+    }
+  }
+
+  // Complete frame including the delimiter; returns its size, 0 if `size` is
+  // smaller than kMaxFrameSize.
+  inline size_t encodeSample(const Sample &sample, uint8_t *frame, size_t size)
+  {
+    if (size < kMaxFrameSize)
+    {
+      return 0;
+    }
+
+    uint8_t  payload[kSamplePayloadSize + kCrcSize];
+    uint8_t *p = payload;
+    *p++       = kSampleType;
+    p          = detail::putLittleEndian(p, sample.sequence, 4);
+    p          = detail::putLittleEndian(p, sample.timestampUs, 4);
+    p          = detail::putLittleEndian(p, static_cast<uint32_t>(sample.values.vShunt), 4);
+    p          = detail::putLittleEndian(p, static_cast<uint32_t>(sample.values.vBus), 4);
+    p          = detail::putLittleEndian(p, static_cast<uint32_t>(sample.values.current), 4);
+    p          = detail::putLittleEndian(p, static_cast<uint16_t>(sample.values.dieTemp), 2);
+    p          = detail::putLittleEndian(p, sample.values.energy, 5);
+    p          = detail::putLittleEndian(p, static_cast<uint64_t>(sample.values.charge), 5);
+    p          = detail::putLittleEndian(p, crc16(payload, kSamplePayloadSize), kCrcSize);
+
+    const size_t encoded = cobsEncode(payload, sizeof(payload), frame);
+    frame[encoded]       = 0;
+    return encoded + 1;
+  }
+
+  // `frame` is one frame without its delimiter. False on a COBS, length, type
+  // or CRC error.
+  inline bool decodeSample(const uint8_t *frame, size_t length, Sample &sample)
+  {
+    uint8_t      payload[kSamplePayloadSize + kCrcSize];
+    const size_t decoded = cobsDecode(frame, length, payload, sizeof(payload));
+    if (decoded != sizeof(payload) || payload[0] != kSampleType)
+    {
+      return false;
+    }
+
+    const uint8_t *p = payload + kSamplePayloadSize;
+    if (detail::getLittleEndian(p, kCrcSize) != crc16(payload, kSamplePayloadSize))
+    {
+      return false;
+    }
+
+    p                     = payload + 1;
+    sample.sequence       = static_cast<uint32_t>(detail::getLittleEndian(p, 4));
+    sample.timestampUs    = static_cast<uint32_t>(detail::getLittleEndian(p, 4));
+    sample.values.vShunt  = static_cast<int32_t>(detail::getLittleEndian(p, 4));
+    sample.values.vBus    = static_cast<int32_t>(detail::getLittleEndian(p, 4));
+    sample.values.current = static_cast<int32_t>(detail::getLittleEndian(p, 4));
+    sample.values.dieTemp = static_cast<int16_t>(detail::getLittleEndian(p, 2));
+    sample.values.energy  = detail::getLittleEndian(p, 5);
+    sample.values.charge  = detail::signExtend(detail::getLittleEndian(p, 5), 40);
+    return true;
+  }
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ring_view.h"
+#include "sorted_window.h"
+
+// Round-robin style long-term history: every tier keeps a fixed number of
+// time-aligned buckets, each rolled up from the tier below it.
+enum class HistoryTier : uint8_t
+{
+  Hour,
+  Day,
+  Week
+};
+
+// Current values in CURRENT LSB counts, energy in ENERGY register counts.
+struct HistoryBucket
+{
+  uint64_t energy; // energy accumulated within the bucket
+  uint32_t startSeconds;
+  uint32_t samples;
+  int32_t  minCurrent;
+  int32_t  maxCurrent;
+  int32_t  meanCurrent;
+};
+
+class TieredHistory
+{
+public:
+  static constexpr size_t kTierCount = 3;
+
+  struct TierSpec
+  {
+    uint32_t    bucketSeconds;
+    size_t      bucketCount;
+    const char *name;
+  };
+
+  static constexpr TierSpec kTiers[kTierCount] = {
+      { 60,       96, "hour" }, // 1 min buckets, ~1.6 h
+      { 15 * 60,  96, "day"  }, // 15 min buckets, 24 h
+      { 105 * 60, 96, "week" }, // 1 h 45 min buckets, 7 days
+  };
+
+  static constexpr size_t kMaxBuckets = 96;
+
+  TieredHistory()
+  {
+    for (size_t tier = 0; tier < kTierCount; ++tier)
+    {
+      m_tiers[tier].head   = 0;
+      m_tiers[tier].count  = 0;
+      m_tiers[tier].closed = 0;
+      resetAccumulator(m_tiers[tier].open, 0);
+    }
+  }
+
+  void addSample(int32_t current, uint64_t energyDelta, uint32_t timestampSeconds)
+  {
+    Accumulator sample;
+    resetAccumulator(sample, timestampSeconds);
+    sample.bucket.samples     = 1;
+    sample.bucket.minCurrent  = current;
+    sample.bucket.maxCurrent  = current;
+    sample.bucket.energy      = energyDelta;
+    sample.currentSum         = current;
+
+    merge(0, sample);
+  }
+
+  // Replays a closed bucket of the finest tier, e.g. one restored from flash;
+  // it rolls up into the coarser tiers like live samples. Buckets must come in
+  // time order and before any newer sample. The bucket is closed right away,
+  // so it counts in closedCount() and never closes again with a live sample.
+  void addBucket(const HistoryBucket &bucket)
+  {
+    Accumulator input;
+    input.bucket     = bucket;
+    input.currentSum = static_cast<int64_t>(bucket.meanCurrent) * bucket.samples;
+
+    merge(0, input);
+    close(0);
+  }
+
+  static const TierSpec &spec(HistoryTier tier)
+  {
+    return kTiers[static_cast<size_t>(tier)];
+  }
+
+  // Closed buckets of the tier, oldest first.
+  RingView<HistoryBucket> buckets(HistoryTier tier) const
+  {
+    const Tier &t = m_tiers[static_cast<size_t>(tier)];
+    return RingView<HistoryBucket>::fromRing(t.buckets, spec(tier).bucketCount, t.head, t.count);
+  }
+
+  // Buckets closed since boot; tells a consumer that buckets() has grown.
+  uint32_t closedCount(HistoryTier tier) const
+  {
+    return m_tiers[static_cast<size_t>(tier)].closed;
+  }
+
+  // Bucket currently being filled; samples == 0 while it is empty.
+  HistoryBucket openBucket(HistoryTier tier) const
+  {
+    return finalize(m_tiers[static_cast<size_t>(tier)].open);
+  }
+
+  // Order statistics over the buckets() of the tier and the open bucket, for
+  // the mean current and the energy per bucket; 0 while the tier is empty.
+  int32_t meanCurrentQuantile(HistoryTier tier, float q) const
+  {
+    const Tier         &t    = m_tiers[static_cast<size_t>(tier)];
+    const HistoryBucket open = finalize(t.open);
+    if (open.samples > 0)
+      return t.sortedMeans.quantileWith(open.meanCurrent, q);
+    return (t.sortedMeans.size() > 0) ? t.sortedMeans.quantile(q) : 0;
+  }
+
+  uint64_t energyQuantile(HistoryTier tier, float q) const
+  {
+    const Tier &t = m_tiers[static_cast<size_t>(tier)];
+    if (t.open.bucket.samples > 0)
+      return t.sortedEnergy.quantileWith(t.open.bucket.energy, q);
+    return (t.sortedEnergy.size() > 0) ? t.sortedEnergy.quantile(q) : 0;
+  }
+
+private:
+  struct Accumulator
+  {
+    HistoryBucket bucket;
+    int64_t       currentSum;
+  };
+
+  struct Tier
+  {
+    HistoryBucket buckets[kMaxBuckets];
+    size_t        head;
+    size_t        count;
+    uint32_t      closed;
+    Accumulator   open;
+
+    SortedWindow<int32_t, kMaxBuckets>  sortedMeans;
+    SortedWindow<uint64_t, kMaxBuckets> sortedEnergy;
+  };
+
+  static void resetAccumulator(Accumulator &acc, uint32_t startSeconds)
+  {
+    acc.bucket.startSeconds = startSeconds;
+    acc.bucket.samples      = 0;
+    acc.bucket.minCurrent   = 0;
+    acc.bucket.maxCurrent   = 0;
+    acc.bucket.meanCurrent  = 0;
+    acc.bucket.energy       = 0;
+    acc.currentSum          = 0;
+  }
+
+  static HistoryBucket finalize(const Accumulator &acc)
+  {
+    HistoryBucket result = acc.bucket;
+    if (result.samples > 0)
+    {
+      result.meanCurrent = static_cast<int32_t>(acc.currentSum / static_cast<int64_t>(result.samples));
+    }
+    return result;
+  }
+
+  void merge(size_t tierIndex, const Accumulator &input)
+  {
+    Tier          &tier  = m_tiers[tierIndex];
+    const uint32_t width = kTiers[tierIndex].bucketSeconds;
+    const uint32_t start = input.bucket.startSeconds - (input.bucket.startSeconds % width);
+
+    if (tier.open.bucket.samples > 0 && tier.open.bucket.startSeconds != start)
+    {
+      close(tierIndex);
+    }
+
+    Accumulator &acc = tier.open;
+    if (acc.bucket.samples == 0)
+    {
+      resetAccumulator(acc, start);
+      acc.bucket.minCurrent = input.bucket.minCurrent;
+      acc.bucket.maxCurrent = input.bucket.maxCurrent;
+    }
+
+    if (input.bucket.minCurrent < acc.bucket.minCurrent) acc.bucket.minCurrent = input.bucket.minCurrent;
+    if (input.bucket.maxCurrent > acc.bucket.maxCurrent) acc.bucket.maxCurrent = input.bucket.maxCurrent;
+
+    acc.bucket.samples  += input.bucket.samples;
+    acc.bucket.energy   += input.bucket.energy;
+    acc.currentSum      += input.currentSum;
+  }
+
+  void close(size_t tierIndex)
+  {
+    Tier        &tier     = m_tiers[tierIndex];
+    const size_t capacity = kTiers[tierIndex].bucketCount;
+
+    const HistoryBucket bucket  = finalize(tier.open);
+    const HistoryBucket evicted = tier.buckets[tier.head];
+    if (tier.count == capacity)
+    {
+      tier.sortedMeans.replace(evicted.meanCurrent, bucket.meanCurrent);
+      tier.sortedEnergy.replace(evicted.energy, bucket.energy);
+    }
+    else
+    {
+      tier.sortedMeans.insert(bucket.meanCurrent);
+      tier.sortedEnergy.insert(bucket.energy);
+    }
+
+    tier.buckets[tier.head] = bucket;
+    tier.head               = (tier.head + 1) % capacity;
+    if (tier.count < capacity)
+    {
+      ++tier.count;
+    }
+    ++tier.closed;
+
+    // Closed buckets roll up into the next coarser tier.
+    const Accumulator closed = tier.open;
+    resetAccumulator(tier.open, 0);
+    if (tierIndex + 1 < kTierCount)
+    {
+      merge(tierIndex + 1, closed);
+    }
+  }
+
+  Tier m_tiers[kTierCount];
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ina_values.h"
+
+// Oscilloscope-style single-shot trigger on the acquisition path. While armed,
+// every sample goes into one ring; a level crossing marks the trigger and,
+// `postSamples` samples later, the ring is frozen and read in place as the
+// capture. push() is O(1) and never copies the pre-trigger samples.
+class TriggerCapture
+{
+public:
+  static constexpr size_t kCapacity = 128;
+
+  enum class Source : uint8_t
+  {
+    Current,
+    BusVoltage
+  };
+
+  enum class Edge : uint8_t
+  {
+    Rising,
+    Falling
+  };
+
+  enum class State : uint8_t
+  {
+    Idle,
+    Armed,     // waiting for the level crossing
+    Triggered, // collecting post-trigger samples
+    Captured   // frozen until the next arm()
+  };
+
+  struct Config
+  {
+    Source   source      = Source::Current;
+    Edge     edge        = Edge::Rising;
+    int32_t  level       = 0; // raw CURRENT or VBUS code
+    uint16_t preSamples  = 32;
+    uint16_t postSamples = 64;
+  };
+
+  // raw register codes, as in InaValues
+  struct Sample
+  {
+    uint32_t timestampMs;
+    int32_t  current;
+    int32_t  vBus;
+  };
+
+  TriggerCapture()
+      : m_ring()
+      , m_config()
+      , m_state(State::Idle)
+      , m_head(0)
+      , m_filled(0)
+      , m_pre(0)
+      , m_remaining(0)
+      , m_start(0)
+      , m_count(0)
+      , m_previous(0)
+      , m_hasPrevious(false)
+      , m_captureId(0)
+  {
+  }
+
+  // Raw level code for a threshold in A or V.
+  static int32_t levelCode(Source source, float baseValue)
+  {
+    const float lsb = (source == Source::Current) ? ina::CurrentScale::kFactor : ina::BusVoltageScale::kFactor;
+    const float raw = baseValue / lsb;
+    return static_cast<int32_t>(raw < 0.0f ? raw - 0.5f : raw + 0.5f);
+  }
+
+  // Starts a new single-shot capture, discarding the previous one. The trigger
+  // sample sits between the pre- and post-trigger samples, so they must leave
+  // room for it.
+  bool arm(const Config &config)
+  {
+    if (static_cast<size_t>(config.preSamples) + config.postSamples + 1 > kCapacity)
+      return false;
+
+    m_config      = config;
+    m_state       = State::Armed;
+    m_filled      = 0;
+    m_count       = 0;
+    m_hasPrevious = false;
+    return true;
+  }
+
+  void disarm()
+  {
+    if (m_state != State::Captured)
+      m_state = State::Idle;
+  }
+
+  void push(const Sample &sample)
+  {
+    if (m_state != State::Armed && m_state != State::Triggered)
+      return;
+
+    m_ring[m_head] = sample;
+    m_head         = (m_head + 1 < kCapacity) ? m_head + 1 : 0;
+    if (m_filled < kCapacity)
+      ++m_filled;
+
+    if (m_state == State::Triggered)
+    {
+      if (--m_remaining == 0)
+        freeze();
+      return;
+    }
+
+    const int32_t value   = (m_config.source == Source::Current) ? sample.current : sample.vBus;
+    const int32_t level   = m_config.level;
+    const bool    crossed = m_hasPrevious && ((m_config.edge == Edge::Rising) ? (m_previous < level && value >= level)
+                                                                             : (m_previous > level && value <= level));
+    m_previous    = value;
+    m_hasPrevious = true;
+
+    if (!crossed)
+      return;
+
+    m_pre       = (m_filled - 1 < m_config.preSamples) ? m_filled - 1 : m_config.preSamples;
+    m_remaining = m_config.postSamples;
+    m_state     = State::Triggered;
+    if (m_remaining == 0)
+      freeze();
+  }
+
+  State state() const
+  {
+    return m_state;
+  }
+
+  const Config &config() const
+  {
+    return m_config;
+  }
+
+  // counts completed captures, 0 = none yet
+  uint32_t captureId() const
+  {
+    return m_captureId;
+  }
+
+  // The capture, valid while state() == Captured.
+  size_t count() const
+  {
+    return m_count;
+  }
+
+  size_t triggerIndex() const
+  {
+    return m_pre;
+  }
+
+  const Sample &sample(size_t index) const
+  {
+    const size_t position = m_start + index;
+    return m_ring[(position < kCapacity) ? position : position - kCapacity];
+  }
+
+private:
+  void freeze()
+  {
+    m_count = m_pre + 1 + m_config.postSamples;
+    m_start = (m_head + kCapacity - m_count) % kCapacity;
+    m_state = State::Captured;
+    ++m_captureId;
+  }
+
+  Sample   m_ring[kCapacity];
+  Config   m_config;
+  State    m_state;
+  size_t   m_head;
+  size_t   m_filled;
+  size_t   m_pre;       // pre-trigger samples in the capture
+  size_t   m_remaining; // post-trigger samples still to come
+  size_t   m_start;
+  size_t   m_count;
+  int32_t  m_previous;
+  bool     m_hasPrevious;
+  uint32_t m_captureId;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
 
 struct ValuePrefix
 {
@@ -9,5 +10,85 @@ struct ValuePrefix
 };
 
 ValuePrefix findValuePrefix(float absValue);
-String      formatValue(float baseValue, const char *baseUnit, uint8_t digits);
-String      formatTime(float seconds);
+
+// SI-prefixed value with `digits` significant digits and the unit padded to
+// three characters ("12.345 mA "). All formatters write into the caller's
+// buffer (always NUL-terminated, truncated if too small), never allocate and
+// never go through printf; they return the number of characters written.
+size_t formatValue(char *buffer, size_t size, float baseValue, const char *baseUnit, uint8_t digits);
+
+// Plain "-12.345" with a fixed number of decimals (at most 9), like "%.*f".
+size_t formatDecimal(char *buffer, size_t size, float value, uint8_t decimals);
+
+// Same output rules for an exact fixed-point value: value * 10^exp10 base units.
+size_t formatFixed(char *buffer, size_t size, int64_t value, int exp10, const char *baseUnit, uint8_t digits);
+
+// "01h02m03s"; above 99 hours "01d02h03m".
+size_t formatTime(char *buffer, size_t size, uint32_t seconds);
+
+// Raw LSB count with a compile-time FixedScale (see ina_values.h).
+template <typename Scale>
+size_t formatScaled(char *buffer, size_t size, int64_t raw, const char *baseUnit, uint8_t digits)
+{
+  int64_t value = raw * Scale::kNum;
+  int     exp10 = Scale::kExp10;
+
+  if (Scale::kDen != 1)
+  {
+    // keep a few extra decimals before the integer division
+    for (uint8_t i = 0; i < 6 && value < INT64_MAX / 10 && value > INT64_MIN / 10; ++i)
+    {
+      value *= 10;
+      --exp10;
+    }
+    value = (value >= 0) ? (value + Scale::kDen / 2) / Scale::kDen : (value - Scale::kDen / 2) / Scale::kDen;
+  }
+
+  return formatFixed(buffer, size, value, exp10, baseUnit, digits);
+}
+
+// Stack-allocated formatted text, so call sites can format inline:
+//   Serial.printf("I=%s\n", ValueText(current, "A", 5).c_str());
+class ValueText
+{
+public:
+  ValueText(float baseValue, const char *baseUnit, uint8_t digits)
+  {
+    m_length = formatValue(m_text, sizeof(m_text), baseValue, baseUnit, digits);
+  }
+
+  template <typename Scale>
+  static ValueText fromRaw(int64_t raw, const char *baseUnit, uint8_t digits)
+  {
+    ValueText text;
+    text.m_length = formatScaled<Scale>(text.m_text, sizeof(text.m_text), raw, baseUnit, digits);
+    return text;
+  }
+
+  static ValueText time(uint32_t seconds)
+  {
+    ValueText text;
+    text.m_length = formatTime(text.m_text, sizeof(text.m_text), seconds);
+    return text;
+  }
+
+  const char *c_str() const
+  {
+    return m_text;
+  }
+
+  size_t length() const
+  {
+    return m_length;
+  }
+
+private:
+  ValueText()
+      : m_length(0)
+  {
+    m_text[0] = '\0';
+  }
+
+  char   m_text[24];
+  size_t m_length;
+};
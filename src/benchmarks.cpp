@@ -0,0 +1,291 @@
+// Host-side microbenchmarks of the portable kernels that the firmware runs on
+// every sample or frame (everything under include/ plus value_format.cpp).
+//
+//   pio run -e native
+//   .pio/build/native/program [filter]
+//
+// Prints ns/op and heap allocations per op for every kernel whose name
+// contains `filter`. The numbers are for comparing changes on one machine,
+// not an estimate of the ESP8266 timing; none of the kernels should allocate.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <new>
+
+#include "compressed_history.h"
+#include "frame_diff.h"
+#include "graph_scale.h"
+#include "measurement_history.h"
+#include "sorted_window.h"
+#include "telemetry_frame.h"
+#include "tiered_history.h"
+#include "trigger_capture.h"
+#include "value_format.h"
+
+namespace
+{
+  uint64_t allocations = 0;
+}
+
+void *operator new(size_t size)
+{
+  ++allocations;
+  if (void *p = malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+  free(p);
+}
+
+namespace
+{
+  constexpr double MIN_RUN_SECONDS = 0.2;
+
+  // keeps results alive so the optimizer can't drop the kernel
+  volatile uint64_t sink = 0;
+
+  // deterministic pseudo-random input, xorshift32
+  uint32_t nextRandom(uint32_t &state)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  // Runs `kernel(i)` in growing batches until MIN_RUN_SECONDS have passed.
+  template <typename Kernel>
+  void run(const char *filter, const char *name, Kernel &&kernel)
+  {
+    if (filter != nullptr && strstr(name, filter) == nullptr)
+      return;
+
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t iterations = 0;
+    uint64_t batch      = 16;
+    uint64_t allocated  = 0;
+    double   seconds    = 0.0;
+    while (seconds < MIN_RUN_SECONDS)
+    {
+      const uint64_t    allocsBefore = allocations;
+      const Clock::time_point start  = Clock::now();
+      for (uint64_t i = 0; i < batch; ++i)
+      {
+        kernel(iterations + i);
+      }
+      seconds += std::chrono::duration<double>(Clock::now() - start).count();
+      allocated += allocations - allocsBefore;
+      iterations += batch;
+      batch *= 2;
+    }
+
+    printf("%-32s %12.1f ns/op %10.3f allocs/op %12llu ops\n", name, seconds * 1e9 / iterations,
+           static_cast<double>(allocated) / iterations, static_cast<unsigned long long>(iterations));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  const char *filter = (argc > 1) ? argv[1] : nullptr;
+  uint32_t    random = 0x12345678;
+
+  printf("%-32s %18s %20s\n", "kernel", "time", "heap");
+
+  // acquisition path
+
+  {
+    MeasurementHistory history;
+    uint64_t           energy = 0;
+    run(filter, "history.addMeasurement", [&](uint64_t i)
+        {
+          energy += 100;
+          history.addMeasurement(static_cast<int32_t>(nextRandom(random) % 200000) - 100000, energy,
+                                 static_cast<uint32_t>(i));
+        });
+    run(filter, "history.getCurrentStats", [&](uint64_t)
+        {
+          sink = sink + static_cast<uint64_t>(history.getCurrentStats().maxCurrent);
+        });
+    run(filter, "history.forEachSince(16)", [&](uint64_t)
+        {
+          history.forEachSince(history.nextSequence() - 16, [&](uint32_t seq, int32_t current, uint64_t, uint32_t)
+                               {
+                                 sink = sink + seq + static_cast<uint64_t>(current);
+                               });
+        });
+  }
+
+  {
+    static SampleArchive archive;
+    InaValues            values = {};
+    run(filter, "archive.add", [&](uint64_t i)
+        {
+          values.current += static_cast<int32_t>(nextRandom(random) % 201) - 100;
+          values.energy += nextRandom(random) % 50;
+          values.vBus = 25600 + static_cast<int32_t>(nextRandom(random) % 7);
+          archive.add(values, static_cast<uint32_t>(i * 2400));
+        });
+    run(filter, "archive.forEachSince(all)", [&](uint64_t)
+        {
+          archive.forEachSince(0, [&](uint32_t seq, const SampleArchive::Sample &sample)
+                               {
+                                 sink = sink + seq + static_cast<uint64_t>(sample.current);
+                               });
+        });
+  }
+
+  {
+    static SortedWindow<int32_t, 4096> window;
+    static int32_t                     ring[4096];
+    for (size_t i = 0; i < 4096; ++i)
+    {
+      ring[i] = static_cast<int32_t>(nextRandom(random) % 200000) - 100000;
+      window.insert(ring[i]);
+    }
+    run(filter, "sortedWindow.replace(4096)", [&](uint64_t i)
+        {
+          const int32_t value = static_cast<int32_t>(nextRandom(random) % 200000) - 100000;
+          window.replace(ring[i % 4096], value);
+          ring[i % 4096] = value;
+        });
+    run(filter, "sortedWindow.quantile(4096)", [&](uint64_t)
+        {
+          sink = sink + static_cast<uint64_t>(window.quantile(0.05f) + window.quantile(0.95f));
+        });
+  }
+
+  {
+    static TieredHistory tiered;
+    run(filter, "tiered.addSample", [&](uint64_t i)
+        {
+          tiered.addSample(static_cast<int32_t>(nextRandom(random) % 1000), 10, static_cast<uint32_t>(i / 8));
+        });
+  }
+
+  {
+    static TriggerCapture      capture;
+    TriggerCapture::Config     config;
+    config.level = 500;
+    capture.arm(config);
+    run(filter, "trigger.push", [&](uint64_t i)
+        {
+          if (capture.state() == TriggerCapture::State::Captured)
+            capture.arm(config);
+          capture.push({static_cast<uint32_t>(i), static_cast<int32_t>(nextRandom(random) % 1000), 0});
+        });
+  }
+
+  {
+    telemetry::Sample sample = {};
+    uint8_t           frame[telemetry::kMaxFrameSize];
+    run(filter, "telemetry.encodeSample", [&](uint64_t i)
+        {
+          sample.sequence       = static_cast<uint32_t>(i);
+          sample.values.current = static_cast<int32_t>(nextRandom(random));
+          sink                  = sink + telemetry::encodeSample(sample, frame, sizeof(frame));
+        });
+    run(filter, "telemetry.crc16(27)", [&](uint64_t)
+        {
+          frame[0] = static_cast<uint8_t>(nextRandom(random));
+          sink     = sink + telemetry::crc16(frame, telemetry::kSamplePayloadSize);
+        });
+  }
+
+  // formatting, once per displayed or served value
+
+  {
+    char text[24];
+    run(filter, "formatValue", [&](uint64_t)
+        {
+          const float value = static_cast<float>(nextRandom(random) % 100000) * 1e-5f;
+          sink              = sink + formatValue(text, sizeof(text), value, "A", 5);
+        });
+    run(filter, "formatScaled<Current>", [&](uint64_t)
+        {
+          sink = sink + formatScaled<ina::CurrentScale>(text, sizeof(text), nextRandom(random) % 500000, "A", 5);
+        });
+    run(filter, "formatDecimal", [&](uint64_t)
+        {
+          sink = sink + formatDecimal(text, sizeof(text), static_cast<float>(nextRandom(random) % 10000) * 0.01f, 3);
+        });
+    run(filter, "formatTime", [&](uint64_t)
+        {
+          sink = sink + formatTime(text, sizeof(text), nextRandom(random) % 400000);
+        });
+  }
+
+  // display, once per frame
+
+  {
+    constexpr size_t kPoints = 64;
+    float            values[kPoints];
+    for (size_t i = 0; i < kPoints; ++i)
+    {
+      values[i] = static_cast<float>(nextRandom(random) % 1000);
+    }
+
+    GraphScaleState state;
+    run(filter, "updateGraphScale", [&](uint64_t i)
+        {
+          updateGraphScale(state, values[i % kPoints], values[(i + 7) % kPoints] + 1000.0f);
+          sink = sink + static_cast<uint64_t>(state.max);
+        });
+
+    const GraphAxes axes = {0, 63, 128, 48, 0.0f, 0.048f};
+    run(filter, "GraphAxes.x/y(64)", [&](uint64_t)
+        {
+          for (size_t i = 0; i < kPoints; ++i)
+          {
+            sink = sink + static_cast<uint64_t>(axes.x(i / 63.0f) + axes.y(values[i]));
+          }
+        });
+  }
+
+  {
+    constexpr uint16_t kWidth = 128;
+    constexpr uint8_t  kPages = 8;
+    static uint8_t     frame[kWidth * kPages];
+    static uint8_t     shadow[kWidth * kPages];
+    uint32_t           runs = 0;
+    const auto         send = [&](uint8_t, uint8_t, const uint8_t *, uint8_t)
+    {
+      ++runs;
+    };
+
+    run(filter, "flushFrameDiff(unchanged)", [&](uint64_t)
+        {
+          sink = sink + flushFrameDiff(frame, shadow, true, kWidth, kPages, 8, send);
+        });
+    run(filter, "flushFrameDiff(one value)", [&](uint64_t i)
+        {
+          // a redrawn number: a few columns on two pages
+          for (uint16_t column = 80; column < 110; ++column)
+          {
+            frame[2 * kWidth + column] = static_cast<uint8_t>(i + column);
+            frame[3 * kWidth + column] = static_cast<uint8_t>(i - column);
+          }
+          sink = sink + flushFrameDiff(frame, shadow, true, kWidth, kPages, 8, send);
+        });
+    run(filter, "flushFrameDiff(full)", [&](uint64_t)
+        {
+          sink = sink + flushFrameDiff(frame, shadow, false, kWidth, kPages, 8, send);
+        });
+    sink = sink + runs;
+  }
+
+  return 0;
+}
@@ -0,0 +1,122 @@
+#include "burst_capture.h"
+
+namespace
+{
+  // continuous shunt-only conversions (MODE = 0xA), 280 us, no averaging;
+  // shorter conversions would finish faster than two I2C reads at 400 kHz
+  constexpr uint16_t BURST_ADC_CONFIG = Ina228Reader::adcConfig(0xA, 0, 3, 0, 0);
+
+  // give up if no conversion completes within this time
+  constexpr uint32_t CONVERSION_TIMEOUT_US = 5000;
+}
+
+BurstCapture::BurstCapture()
+    : m_current()
+    , m_offsetUs()
+    , m_count(0)
+    , m_captureId(0)
+    , m_minCurrent(0)
+    , m_maxCurrent(0)
+    , m_requested(false)
+{
+}
+
+void BurstCapture::request()
+{
+  m_requested = true;
+}
+
+bool BurstCapture::requested() const
+{
+  return m_requested;
+}
+
+bool BurstCapture::run(Ina228Reader &reader)
+{
+  m_requested = false;
+
+  uint16_t savedConfig = 0;
+  if (!reader.readAdcConfig(savedConfig) || !reader.writeAdcConfig(BURST_ADC_CONFIG))
+  {
+    return false;
+  }
+
+  // drop a conversion still flagged from the normal profile
+  int32_t current = 0;
+  bool    ready   = false;
+  bool    ok      = reader.readCurrentIfReady(current, ready);
+
+  m_count             = 0;
+  uint32_t startUs    = micros();
+  uint32_t lastReadUs = startUs;
+
+  while (ok && m_count < kCapacity)
+  {
+    ok                 = reader.readCurrentIfReady(current, ready);
+    const uint32_t now = micros();
+
+    if (!ready)
+    {
+      ok = ok && (now - lastReadUs) < CONVERSION_TIMEOUT_US;
+      continue;
+    }
+
+    if (m_count == 0)
+    {
+      startUs      = now;
+      m_minCurrent = current;
+      m_maxCurrent = current;
+    }
+
+    m_current[m_count]  = current;
+    m_offsetUs[m_count] = now - startUs;
+    m_minCurrent        = min(m_minCurrent, current);
+    m_maxCurrent        = max(m_maxCurrent, current);
+    ++m_count;
+    lastReadUs = now;
+  }
+
+  const bool restored = reader.writeAdcConfig(savedConfig);
+  reader.clearAlert();
+
+  if (m_count > 0)
+  {
+    ++m_captureId;
+  }
+  return ok && restored;
+}
+
+size_t BurstCapture::count() const
+{
+  return m_count;
+}
+
+uint32_t BurstCapture::captureId() const
+{
+  return m_captureId;
+}
+
+uint32_t BurstCapture::durationUs() const
+{
+  return (m_count > 0) ? m_offsetUs[m_count - 1] : 0;
+}
+
+int32_t BurstCapture::minCurrent() const
+{
+  return m_minCurrent;
+}
+
+int32_t BurstCapture::maxCurrent() const
+{
+  return m_maxCurrent;
+}
+
+int32_t BurstCapture::current(size_t index) const
+{
+  return m_current[index];
+}
+
+uint32_t BurstCapture::offsetUs(size_t index) const
+{
+  return m_offsetUs[index];
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "ina228_reader.h"
+
+// 8 bytes per sample, all of it static RAM. 256 samples cover about 72 ms;
+// larger captures cut into the heap left for WiFi and the web server.
+#ifndef BURST_CAPTURE_CAPACITY
+#define BURST_CAPTURE_CAPACITY 256
+#endif
+
+// One-shot high-rate capture of the CURRENT register for inrush and radio
+// bursts. run() switches the INA228 to continuous shunt-only conversions
+// without averaging, stores every conversion until the buffer is full, then
+// restores the previous ADC_CONFIG. Values are CURRENT LSB counts.
+class BurstCapture
+{
+public:
+  static constexpr size_t kCapacity = BURST_CAPTURE_CAPACITY;
+
+  BurstCapture();
+
+  void request();
+  bool requested() const;
+
+  // Blocks for the whole capture, about kCapacity * 280 us.
+  bool run(Ina228Reader &reader);
+
+  size_t   count() const;
+  uint32_t captureId() const; // counts completed captures, 0 = none yet
+  uint32_t durationUs() const;
+  int32_t  minCurrent() const;
+  int32_t  maxCurrent() const;
+
+  int32_t  current(size_t index) const;
+  uint32_t offsetUs(size_t index) const; // since the first sample
+
+private:
+  int32_t  m_current[kCapacity];
+  uint32_t m_offsetUs[kCapacity];
+  size_t   m_count;
+  uint32_t m_captureId;
+  int32_t  m_minCurrent;
+  int32_t  m_maxCurrent;
+  bool     m_requested;
+};
@@ -1,9 +1,15 @@
 #include "display_manager.h"
 
+#include "alert_events.h"
+#include "burst_capture.h"
+#include "i2c_transfer_queue.h"
+#include "ina_channel.h"
 #include "ina_values.h"
 #include "measurement_history.h"
+#include "profiler.h"
+#include "tiered_history.h"
+#include "trigger_capture.h"
 #include "value_format.h"
-#include "util/small_sort.h"
 #include <math.h>
 #include <string.h>
 
@@ -19,14 +25,39 @@ namespace
   constexpr int16_t  graphMarginBottom    = 34;
   constexpr uint8_t  yTickCount           = 4;
   constexpr uint8_t  xTickCount           = 1; // produces 2 ticks (0 and 1)
-  constexpr float    graphSmoothingAlpha  = 0.2f;
   constexpr float    minGraphRange        = 0.0001f;
   constexpr float    graphPaddingFraction = 0.1f;
+  constexpr int16_t  graphWidth           = SH1107_WIDTH - graphMarginLeft - graphMarginRight;
+  constexpr int16_t  graphHeight          = SH1107_HEIGHT - graphMarginTop - graphMarginBottom;
+  constexpr int16_t  graphOriginX         = graphMarginLeft;
+  constexpr int16_t  graphOriginY         = graphMarginTop + graphHeight;
+
+  HistoryTier tierForRange(GraphRange range)
+  {
+    switch (range)
+    {
+      case GraphRange::Day:
+        return HistoryTier::Day;
+      case GraphRange::Week:
+        return HistoryTier::Week;
+      default:
+        return HistoryTier::Hour;
+    }
+  }
 }
 
 DisplayManager::DisplayManager()
     : m_display(SH1107_HEIGHT, SH1107_WIDTH, &Wire, -1)
     , m_ready(false)
+    , m_lastRange(GraphRange::Recent)
+    , m_lastHistory(nullptr)
+    , m_burst(nullptr)
+    , m_channels(nullptr)
+    , m_channelCount(0)
+    , m_trigger(nullptr)
+    , m_profiler(nullptr)
+    , m_bus(nullptr)
+    , m_flushing(false)
 {
 }
 
@@ -50,6 +81,37 @@ bool DisplayManager::begin()
   return true;
 }
 
+void DisplayManager::attachBurst(const BurstCapture *burst)
+{
+  m_burst = burst;
+}
+
+void DisplayManager::attachChannels(const InaChannel *channels, size_t count)
+{
+  m_channels     = channels;
+  m_channelCount = count;
+}
+
+void DisplayManager::attachTrigger(const TriggerCapture *trigger)
+{
+  m_trigger = trigger;
+}
+
+void DisplayManager::attachProfiler(Profiler *profiler)
+{
+  m_profiler = profiler;
+}
+
+void DisplayManager::attachBus(I2cTransferQueue *bus)
+{
+  m_bus = bus;
+}
+
+bool DisplayManager::busy() const
+{
+  return m_flushing;
+}
+
 void DisplayManager::showConnecting(const char *ssid)
 {
   if (!m_ready)
@@ -71,17 +133,20 @@ void DisplayManager::showConnecting(const char *ssid)
   m_display.display();
 }
 
-void DisplayManager::showMeasurements(const InaValues &values, float deltaEnergyWs, bool sensorOk, bool webConnected, const IPAddress &ip,
-                                      const MeasurementHistory &history, DisplayMode mode)
+void DisplayManager::showMeasurements(const MeterReadings &readings, const char *label, bool webConnected, const IPAddress &ip,
+                                      const TieredHistory &tiers, DisplayMode mode, GraphRange range)
 {
   if (!m_ready)
   {
     return;
   }
 
+  ProfileScope render(m_profiler, ProfileStage::DisplayRender);
   m_display.clearDisplay();
 
-  if (!sensorOk)
+  const InaValues &values = readings.values;
+
+  if (!readings.ok)
   {
     m_display.setCursor(0, lineHeight * 2);
     m_display.setTextSize(1);
@@ -92,17 +157,23 @@ void DisplayManager::showMeasurements(const InaValues &values, float deltaEnergy
     m_display.setCursor(0, 0);
     // last current and energy measurement
     m_display.setTextSize(1);
-    m_display.println(F("Current"));
+    m_display.print(F("Current"));
+    if (label != nullptr)
+    {
+      m_display.print(' ');
+      m_display.print(label);
+    }
+    m_display.println();
     m_display.setCursor(0, m_display.getCursorY() + lineHeight / 2);
 
-    const String currentStr = formatValue(values.current_mA / 1000.0f, "A", 5);
+    const ValueText currentStr = ValueText::fromRaw<ina::CurrentScale>(values.current, "A", 5);
   
-    const String intervalEnergyStr = formatValue(deltaEnergyWs   / 3600.0f, "Wh", 5);
-    const String totalEnergyStr    = formatValue(values.energyWs / 3600.0f, "Wh", 5);
+    const ValueText intervalEnergyStr = ValueText::fromRaw<ina::EnergyWhScale>(static_cast<int64_t>(readings.energyDelta), "Wh", 5);
+    const ValueText totalEnergyStr    = ValueText::fromRaw<ina::EnergyWhScale>(static_cast<int64_t>(values.energy), "Wh", 5);
 
     m_display.setTextSize(2);
-    m_display.println(currentStr);
-    m_display.println(intervalEnergyStr);
+    m_display.println(currentStr.c_str());
+    m_display.println(intervalEnergyStr.c_str());
 
     // total accumulated energy
     m_display.setCursor(0, m_display.getCursorY() + lineHeight * 2);
@@ -111,23 +182,33 @@ void DisplayManager::showMeasurements(const InaValues &values, float deltaEnergy
     m_display.setCursor(0, m_display.getCursorY() + lineHeight / 2);
 
     m_display.setTextSize(2);
-    m_display.println(totalEnergyStr);
+    m_display.println(totalEnergyStr.c_str());
     m_display.println();
 
     // vbus, die temp and IP address on botton
     m_display.setCursor(0, SH1107_HEIGHT - 3 * lineHeight);
     m_display.setTextSize(1);
     m_display.print(F("Vbus: "));
-    m_display.println(formatValue(values.vBus, "V", 4));
+    m_display.println(ValueText::fromRaw<ina::BusVoltageScale>(values.vBus, "V", 4).c_str());
     m_display.print(F("Temp: "));
-    m_display.print(values.temperature, 1);
+    m_display.print(ina::DieTempScale::toFloat(values.dieTemp), 1);
     m_display.println(F(" C"));
   }
+  else if (mode == DisplayMode::Burst)
+  {
+    showBurst();
+  }
+  else if (mode == DisplayMode::Trigger)
+  {
+    showTrigger();
+  }
   else
   {
-    showGraph(history, mode);
+    showGraph(readings.history, tiers, mode, range);
   }
 
+  drawAlertMarker(mode == DisplayMode::Summary);
+
   if (mode == DisplayMode::Summary)
   {
     m_display.setCursor(0, SH1107_HEIGHT - lineHeight);
@@ -143,20 +224,157 @@ void DisplayManager::showMeasurements(const InaValues &values, float deltaEnergy
     }
   }
 
+  render.finish();
+  flush();
+}
+
+// A full queue falls back to the blocking flush.
+void DisplayManager::flush()
+{
+  m_display.startFlush();
+  if (m_bus != nullptr &&
+      m_bus->submit(I2cTransferQueue::Priority::Low, &DisplayManager::flushStep, &DisplayManager::flushDone, this))
+  {
+    m_flushing = true;
+    return;
+  }
+
+  ProfileScope scope(m_profiler, ProfileStage::DisplayFlush);
   m_display.display();
 }
 
-void DisplayManager::showGraph(const MeasurementHistory &history, DisplayMode mode)
+bool DisplayManager::flushStep(void *context)
+{
+  DisplayManager &self = *static_cast<DisplayManager *>(context);
+  ProfileScope    scope(self.m_profiler, ProfileStage::DisplayFlush);
+  return self.m_display.flushNextPage();
+}
+
+void DisplayManager::flushDone(void *context)
+{
+  static_cast<DisplayManager *>(context)->m_flushing = false;
+}
+
+// "!SHNTOL" while a limit is violated, otherwise the number of limit events
+// since boot, over all channels. Top right on the summary, top left next to
+// the graph titles.
+void DisplayManager::drawAlertMarker(bool alignRight)
+{
+  uint32_t total  = 0;
+  uint16_t active = 0;
+  for (size_t i = 0; i < m_channelCount; ++i)
+  {
+    total += m_channels[i].alerts.total();
+    active |= m_channels[i].alerts.active();
+  }
+  if (total == 0)
+    return;
+
+  const char *name = nullptr;
+  forEachAlertFlag(active,
+                   [&](const char *flag)
+                   {
+                     if (name == nullptr)
+                       name = flag;
+                   });
+
+  size_t length = 2; // '!' and the first digit
+  for (uint32_t rest = total; rest >= 10; rest /= 10)
+    ++length;
+  if (name != nullptr)
+    length = strlen(name) + 1;
+
+  m_display.setTextSize(1);
+  m_display.setCursor(alignRight ? SH1107_WIDTH - static_cast<int16_t>(length * 6) : 0, 0);
+  if (name != nullptr)
+  {
+    m_display.print('!');
+    m_display.print(name);
+  }
+  else
+  {
+    m_display.print(total);
+    m_display.print('!');
+  }
+}
+
+// Read-only accessor over whatever the graph plots: the raw sample ring or the
+// buckets of one history tier (plus the bucket still being filled). Values are
+// read straight out of the history, nothing is copied.
+struct DisplayManager::GraphSeries
+{
+  RingView<int32_t>       currents;
+  RingView<uint64_t>      energy;
+  RingView<uint32_t>      times;
+  RingView<HistoryBucket> buckets;
+  HistoryBucket           openBucket;
+  bool                    useBuckets;
+  bool                    showCurrent;
+
+  size_t size() const
+  {
+    if (!useBuckets)
+      return times.size();
+
+    return buckets.size() + (openBucket.samples > 0 ? 1 : 0);
+  }
+
+  const HistoryBucket &bucket(size_t index) const
+  {
+    return (index < buckets.size()) ? buckets[index] : openBucket;
+  }
+
+  // value in raw LSB counts (CURRENT or ENERGY register units)
+  float value(size_t index) const
+  {
+    if (!useBuckets)
+      return showCurrent ? static_cast<float>(currents[index]) : static_cast<float>(energy[index]);
+
+    const HistoryBucket &b = bucket(index);
+    return showCurrent ? static_cast<float>(b.meanCurrent) : static_cast<float>(b.energy);
+  }
+
+  // seconds since boot
+  float time(size_t index) const
+  {
+    return useBuckets ? static_cast<float>(bucket(index).startSeconds) : times[index] * 0.001f;
+  }
+
+  // seconds since the first point, taken as an integer difference before converting
+  float elapsed(size_t index) const
+  {
+    if (useBuckets)
+      return static_cast<float>(bucket(index).startSeconds - bucket(0).startSeconds);
+
+    return static_cast<float>(times[index] - times[0]) * 0.001f;
+  }
+};
+
+void DisplayManager::showGraph(const MeasurementHistory &history, const TieredHistory &tiers, DisplayMode mode, GraphRange graphRange)
 {
-  float      samples[MeasurementHistory::kCapacity];
-  float      timestamps[MeasurementHistory::kCapacity];
   const bool showCurrent = (mode == DisplayMode::GraphCurrent);
+  const bool showTier    = (graphRange != GraphRange::Recent);
   const char *unit       = showCurrent ? "A" : "Wh";
+  const HistoryTier tier = tierForRange(graphRange);
+
+  // tier graphs show the mean current per bucket or the energy used within each bucket
+  GraphSeries series;
+  series.useBuckets  = showTier;
+  series.showCurrent = showCurrent;
+  if (!showTier)
+  {
+    series.currents   = history.currents();
+    series.energy     = history.energy();
+    series.times      = history.timestamps();
+    series.openBucket = HistoryBucket();
+  }
+  else
+  {
+    series.buckets    = tiers.buckets(tier);
+    series.openBucket = tiers.openBucket(tier);
+  }
 
-  size_t count = showCurrent ? history.copyCurrents(samples, MeasurementHistory::kCapacity)
-                             : history.copyEnergy(samples, MeasurementHistory::kCapacity);
-  const size_t tsCount = history.copyTimestamps(timestamps, MeasurementHistory::kCapacity);
-  count                = min(count, tsCount);
+  const size_t count = series.size();
 
   m_display.setCursor(0, 0);
   m_display.setTextSize(1);
@@ -169,15 +387,44 @@ void DisplayManager::showGraph(const MeasurementHistory &history, DisplayMode mo
     return;
   }
 
-  float values[MeasurementHistory::kCapacity];
-  const float conversion = showCurrent ? 0.001f : (1.0f / 3600.0f);
-  for (size_t i = 0; i < count; ++i)
+  const float conversion = showCurrent ? ina::CurrentScale::kFactor : ina::EnergyWhScale::kFactor;
+
+  // restart autoscaling when switching between raw samples and tiers, or channels
+  if (graphRange != m_lastRange || &history != m_lastHistory)
   {
-    values[i] = samples[i] * conversion;
+    m_currentScale = GraphScaleState();
+    m_energyScale  = GraphScaleState();
+    m_lastRange    = graphRange;
+    m_lastHistory  = &history;
+  }
+
+  // the histories keep their quantiles current, nothing is sorted per frame;
+  // current and energy have different types, so each is converted on its own
+  float lowRaw  = 0.0f;
+  float highRaw = 0.0f;
+  if (!showTier && showCurrent)
+  {
+    lowRaw  = static_cast<float>(history.currentQuantile(kGraphLowQuantile));
+    highRaw = static_cast<float>(history.currentQuantile(kGraphHighQuantile));
+  }
+  else if (!showTier)
+  {
+    lowRaw  = static_cast<float>(history.energyQuantile(kGraphLowQuantile));
+    highRaw = static_cast<float>(history.energyQuantile(kGraphHighQuantile));
+  }
+  else if (showCurrent)
+  {
+    lowRaw  = static_cast<float>(tiers.meanCurrentQuantile(tier, kGraphLowQuantile));
+    highRaw = static_cast<float>(tiers.meanCurrentQuantile(tier, kGraphHighQuantile));
+  }
+  else
+  {
+    lowRaw  = static_cast<float>(tiers.energyQuantile(tier, kGraphLowQuantile));
+    highRaw = static_cast<float>(tiers.energyQuantile(tier, kGraphHighQuantile));
   }
 
   GraphScaleState &state = showCurrent ? m_currentScale : m_energyScale;
-  updateScaleWithHistory(state, values, count);
+  updateGraphScale(state, lowRaw * conversion, highRaw * conversion);
 
   float minVal = min(state.min, state.stickyMin);
   float maxVal = max(state.max, state.stickyMax);
@@ -194,101 +441,55 @@ void DisplayManager::showGraph(const MeasurementHistory &history, DisplayMode mo
   maxVal += pad;
   range = maxVal - minVal;
 
-  const int16_t graphWidth  = SH1107_WIDTH - graphMarginLeft - graphMarginRight;
-  const int16_t graphHeight = SH1107_HEIGHT - graphMarginTop - graphMarginBottom;
-  const int16_t originX     = graphMarginLeft;
-  const int16_t originY     = graphMarginTop + graphHeight;
-
-  const float maxAbsValue = max(fabs(minVal), fabs(maxVal));
-  String      unitLabel(unit);
-
-  if (maxAbsValue > 0.0f)
-  {
-    const ValuePrefix prefix = findValuePrefix(maxAbsValue);
-    unitLabel = prefix.symbol;
-    unitLabel += unit;
-    if (unitLabel.length() == 0)
-    {
-      unitLabel = unit;
-    }
-  }
-
-  String title = showCurrent ? "Current (" : "Energy (";
-  title += unitLabel;
-  title += ")";
-
-  int16_t titleX = SH1107_WIDTH - (title.length() * 6);
+  drawGraphFrame(showCurrent ? "Current" : "Energy", unit, minVal, maxVal);
 
-  if (titleX < 0)
-  {
-    titleX = 0;
-  }
+  const float     yScale = (range > 0.0f) ? (static_cast<float>(graphHeight) / range) : 0.0f;
+  const GraphAxes axes   = { graphOriginX, graphOriginY, graphWidth, graphHeight, minVal, yScale };
 
-  m_display.setCursor(titleX, 0);
-  m_display.println(title);
+  const float startTime = series.time(0);
+  const float duration  = max(series.elapsed(count - 1), 0.0001f);
 
-  // axes
-  m_display.drawLine(originX, originY, originX + graphWidth, originY, SH110X_WHITE);
-  m_display.drawLine(originX, originY, originX, originY - graphHeight, SH110X_WHITE);
+  int16_t prevX = graphOriginX;
+  int16_t prevY = axes.y(series.value(0) * conversion);
 
-  // y-axis ticks and labels
-  for (uint8_t i = 0; i <= yTickCount; ++i)
+  for (size_t i = 1; i < count; ++i)
   {
-    const float   position = static_cast<float>(i) / yTickCount;
-    const int16_t y        = originY - static_cast<int16_t>(round(position * graphHeight));
-    const float   value    = minVal + (range * position);
-
-    m_display.drawLine(originX - 3, y, originX, y, SH110X_WHITE);
+    const float relative = (duration > 0.0f) ? (series.elapsed(i) / duration)
+                                             : (static_cast<float>(i) / (count - 1));
 
-    const String label = formatValue(value, nullptr, 4);
-    int16_t      textY = y - lineHeight / 2;
+    const int16_t x = axes.x(relative);
+    const int16_t y = axes.y(series.value(i) * conversion);
 
-    if (textY < 0)
-    {
-      textY = 0;
-    }
-    
-    m_display.setCursor(2, textY);
-    m_display.print(label);
+    m_display.drawLine(prevX, prevY, x, y, SH110X_WHITE);
+    prevX = x;
+    prevY = y;
   }
 
-  const float yScale = (range > 0.0f) ? (static_cast<float>(graphHeight) / range) : 0.0f;
-
-  const float startTime = timestamps[0];
-  const float endTime   = timestamps[count - 1];
-  const float duration  = max(endTime - startTime, 0.0001f);
-
-  int16_t prevX = originX;
-  int16_t prevY = originY - static_cast<int16_t>(round((values[0] - minVal) * yScale));
-  prevY         = constrain(prevY, originY - graphHeight, originY);
-
-  for (size_t i = 1; i < count; ++i)
+  // min/max envelope of every current bucket
+  if (showTier && showCurrent)
   {
-    float relative = (duration > 0.0f) ? ((timestamps[i] - startTime) / duration)
-                                       : (static_cast<float>(i) / (count - 1));
-    relative       = constrain(relative, 0.0f, 1.0f);
-
-    int16_t x = originX + static_cast<int16_t>(round(relative * graphWidth));
-    int16_t y = originY - static_cast<int16_t>(round((values[i] - minVal) * yScale));
+    for (size_t i = 0; i < count; ++i)
+    {
+      const HistoryBucket &bucket = series.bucket(i);
 
-    x = constrain(x, originX, originX + graphWidth);
-    y = constrain(y, originY - graphHeight, originY);
+      const int16_t x  = axes.x(series.elapsed(i) / duration);
+      const int16_t y0 = axes.y(bucket.minCurrent * conversion);
+      const int16_t y1 = axes.y(bucket.maxCurrent * conversion);
 
-    m_display.drawLine(prevX, prevY, x, y, SH110X_WHITE);
-    prevX = x;
-    prevY = y;
+      m_display.drawLine(x, y0, x, y1, SH110X_WHITE);
+    }
   }
 
   // x-axis ticks and labels
   for (uint8_t i = 0; i <= xTickCount; ++i)
   {
     const float   position = static_cast<float>(i) / xTickCount;
-    const int16_t x        = originX + static_cast<int16_t>(round(position * graphWidth));
+    const int16_t x        = axes.x(position);
     const float   seconds  = startTime + (duration * position);
 
-    m_display.drawLine(x, originY, x, originY + 3, SH110X_WHITE);
+    m_display.drawLine(x, graphOriginY, x, graphOriginY + 3, SH110X_WHITE);
 
-    const String label      = formatTime(seconds);
+    const ValueText label   = ValueText::time(static_cast<uint32_t>(seconds + 0.5f));
     const int16_t textWidth = label.length() * 6;
     int16_t      textX      = x - textWidth / 2;
     if (textX < 0)
@@ -300,68 +501,257 @@ void DisplayManager::showGraph(const MeasurementHistory &history, DisplayMode mo
       textX = SH1107_WIDTH - textWidth;
     }
 
-    m_display.setCursor(textX, originY + lineHeight);
-    m_display.print(label);
+    m_display.setCursor(textX, graphOriginY + lineHeight);
+    m_display.print(label.c_str());
   }
 
-  m_display.setCursor(originX + graphWidth - 4 * 6, originY + (lineHeight * 2));
-  m_display.print(F("Time"));
+  const char   *rangeLabel = showTier ? TieredHistory::spec(tier).name : "Time";
+  const int16_t rangeWidth = strlen(rangeLabel) * 6;
+  m_display.setCursor(graphOriginX + graphWidth - rangeWidth, graphOriginY + (lineHeight * 2));
+  m_display.print(rangeLabel);
 }
 
-void DisplayManager::updateScaleWithHistory(GraphScaleState &state, const float *values, size_t count)
+// Last burst capture: one min/max envelope per pixel column, so short spikes
+// stay visible even though ~8 samples share a column.
+void DisplayManager::showBurst()
 {
-  if (count == 0)
+  if (m_burst == nullptr || m_burst->captureId() == 0)
   {
+    m_display.setCursor(0, lineHeight * 2);
+    m_display.println(F("Burst: none"));
+    m_display.setCursor(0, lineHeight * 4);
+    m_display.println(F("Long press to"));
+    m_display.println(F("capture"));
     return;
   }
 
-  float sorted[MeasurementHistory::kCapacity];
-  memcpy(sorted, values, count * sizeof(float));
-  insertionSort(sorted, count);
+  const size_t count      = m_burst->count();
+  const float  conversion = static_cast<float>(ina::kCurrentLsbA);
 
-  const size_t lowIndex  = static_cast<size_t>(roundf(0.05f * (count - 1)));
-  const size_t highIndex = static_cast<size_t>(roundf(0.95f * (count - 1)));
-  const float  rawMin    = sorted[min(lowIndex, count - 1)];
-  const float  rawMax    = sorted[min(highIndex, count - 1)];
+  float       minVal = m_burst->minCurrent() * conversion;
+  float       maxVal = m_burst->maxCurrent() * conversion;
+  const float pad    = max(maxVal - minVal, minGraphRange) * graphPaddingFraction;
+  minVal -= pad;
+  maxVal += pad;
+  const float range = maxVal - minVal;
 
-  constexpr uint8_t stickyHoldFrames = 30;
+  drawGraphFrame("Burst", "A", minVal, maxVal);
 
-  if (!state.initialized)
+  const GraphAxes axes     = { graphOriginX, graphOriginY, graphWidth, graphHeight, minVal, graphHeight / range };
+  const float     duration = max(static_cast<float>(m_burst->durationUs()), 1.0f);
+
+  auto toY = [&](int32_t raw) -> int16_t
+  {
+    return axes.y(raw * conversion);
+  };
+
+  size_t  index = 0;
+  int16_t prevY = -1;
+  for (int16_t column = 0; column < graphWidth && index < count; ++column)
   {
-    state.min         = rawMin;
-    state.max         = rawMax;
-    state.stickyMin   = rawMin;
-    state.stickyMax   = rawMax;
-    state.holdFrames  = stickyHoldFrames;
-    state.initialized = true;
+    // samples up to the end of this column; the last column takes the rest
+    const float limit = duration * (column + 1) / graphWidth;
+    if (m_burst->offsetUs(index) > limit && column + 1 < graphWidth)
+      continue;
+
+    int32_t lo   = m_burst->current(index);
+    int32_t hi   = lo;
+    int32_t last = lo;
+    while (index < count && (m_burst->offsetUs(index) <= limit || column + 1 == graphWidth))
+    {
+      last = m_burst->current(index);
+      lo   = min(lo, last);
+      hi   = max(hi, last);
+      ++index;
+    }
+
+    // extend to the previous column's last sample so the trace has no gaps
+    int16_t top    = toY(hi);
+    int16_t bottom = toY(lo);
+    if (prevY >= 0)
+    {
+      top    = min(top, prevY);
+      bottom = max(bottom, prevY);
+    }
+
+    const int16_t x = graphOriginX + column;
+    m_display.drawLine(x, top, x, bottom, SH110X_WHITE);
+    prevY = toY(last);
+  }
+
+  const ValueText end(m_burst->durationUs() * 1e-6f, "s", 4);
+  m_display.drawLine(graphOriginX, graphOriginY, graphOriginX, graphOriginY + 3, SH110X_WHITE);
+  m_display.drawLine(graphOriginX + graphWidth, graphOriginY, graphOriginX + graphWidth, graphOriginY + 3, SH110X_WHITE);
+  m_display.setCursor(graphOriginX - 3, graphOriginY + lineHeight);
+  m_display.print('0');
+  m_display.setCursor(SH1107_WIDTH - end.length() * 6, graphOriginY + lineHeight);
+  m_display.print(end.c_str());
+
+  m_display.setCursor(graphOriginX, graphOriginY + (lineHeight * 2));
+  m_display.print(F("Burst #"));
+  m_display.print(m_burst->captureId());
+}
+
+// Frozen trigger capture, one point per sample with the trigger position and
+// level dotted in. Before that the trigger settings and state.
+void DisplayManager::showTrigger()
+{
+  if (m_trigger == nullptr)
+    return;
+
+  const TriggerCapture::Config &config     = m_trigger->config();
+  const bool                    isCurrent  = (config.source == TriggerCapture::Source::Current);
+  const char                   *unit       = isCurrent ? "A" : "V";
+  const float                   conversion = isCurrent ? ina::CurrentScale::kFactor : ina::BusVoltageScale::kFactor;
+
+  if (m_trigger->state() != TriggerCapture::State::Captured)
+  {
+    m_display.setCursor(0, lineHeight * 2);
+    switch (m_trigger->state())
+    {
+      case TriggerCapture::State::Armed:
+        m_display.println(F("Trigger: armed"));
+        break;
+      case TriggerCapture::State::Triggered:
+        m_display.println(F("Trigger: triggered"));
+        break;
+      default:
+        m_display.println(F("Trigger: idle"));
+        break;
+    }
+
+    m_display.setCursor(0, lineHeight * 4);
+    m_display.print(isCurrent ? F("I ") : F("Vbus "));
+    m_display.print(config.edge == TriggerCapture::Edge::Rising ? F("rising ") : F("falling "));
+    m_display.println(ValueText(config.level * conversion, unit, 4).c_str());
+    m_display.print(F("pre "));
+    m_display.print(config.preSamples);
+    m_display.print(F(" post "));
+    m_display.println(config.postSamples);
+    m_display.setCursor(0, lineHeight * 8);
+    m_display.println(F("Long press to arm"));
     return;
   }
 
-  state.min += (rawMin - state.min) * graphSmoothingAlpha;
-  state.max += (rawMax - state.max) * graphSmoothingAlpha;
+  const size_t count   = m_trigger->count();
+  const size_t trigger = m_trigger->triggerIndex();
+
+  auto value = [&](size_t index) -> float
+  {
+    const TriggerCapture::Sample &sample = m_trigger->sample(index);
+    return (isCurrent ? sample.current : sample.vBus) * conversion;
+  };
 
-  if (rawMin < state.stickyMin || state.holdFrames == 0)
+  float minVal = config.level * conversion;
+  float maxVal = minVal;
+  for (size_t i = 0; i < count; ++i)
   {
-    state.stickyMin  = rawMin;
-    state.holdFrames = stickyHoldFrames;
+    minVal = min(minVal, value(i));
+    maxVal = max(maxVal, value(i));
   }
-  else if (rawMin > state.stickyMin)
+  const float pad = max(maxVal - minVal, minGraphRange) * graphPaddingFraction;
+  minVal -= pad;
+  maxVal += pad;
+  const GraphAxes axes = { graphOriginX, graphOriginY, graphWidth, graphHeight, minVal, graphHeight / (maxVal - minVal) };
+
+  drawGraphFrame("Trigger", unit, minVal, maxVal);
+
+  auto toX = [&](size_t index) -> int16_t
   {
-    state.stickyMin += (rawMin - state.stickyMin) * (graphSmoothingAlpha * 0.5f);
+    return axes.x((count > 1) ? static_cast<float>(index) / (count - 1) : 0.0f);
+  };
+
+  // trigger position and level
+  const int16_t triggerX = toX(trigger);
+  const int16_t levelY   = axes.y(config.level * conversion);
+  for (int16_t y = graphOriginY - graphHeight; y < graphOriginY; y += 3)
+    m_display.drawPixel(triggerX, y, SH110X_WHITE);
+  for (int16_t x = graphOriginX; x < graphOriginX + graphWidth; x += 3)
+    m_display.drawPixel(x, levelY, SH110X_WHITE);
+
+  int16_t prevX = toX(0);
+  int16_t prevY = axes.y(value(0));
+  for (size_t i = 1; i < count; ++i)
+  {
+    const int16_t x = toX(i);
+    const int16_t y = axes.y(value(i));
+    m_display.drawLine(prevX, prevY, x, y, SH110X_WHITE);
+    prevX = x;
+    prevY = y;
   }
 
-  if (rawMax > state.stickyMax || state.holdFrames == 0)
+  // time axis relative to the trigger sample
+  const uint32_t  triggerMs = m_trigger->sample(trigger).timestampMs;
+  const ValueText before(-static_cast<float>(triggerMs - m_trigger->sample(0).timestampMs) * 0.001f, "s", 4);
+  const ValueText after(static_cast<float>(m_trigger->sample(count - 1).timestampMs - triggerMs) * 0.001f, "s", 4);
+
+  m_display.drawLine(triggerX, graphOriginY, triggerX, graphOriginY + 3, SH110X_WHITE);
+  m_display.setCursor(0, graphOriginY + lineHeight);
+  m_display.print(before.c_str());
+  m_display.setCursor(SH1107_WIDTH - after.length() * 6, graphOriginY + lineHeight);
+  m_display.print(after.c_str());
+
+  m_display.setCursor(graphOriginX, graphOriginY + (lineHeight * 2));
+  m_display.print(F("Trigger #"));
+  m_display.print(m_trigger->captureId());
+}
+
+// Title with the prefixed unit, both axes and the labelled y ticks.
+void DisplayManager::drawGraphFrame(const char *name, const char *unit, float minVal, float maxVal)
+{
+  const float range = maxVal - minVal;
+
+  const float maxAbsValue = max(fabs(minVal), fabs(maxVal));
+  String      unitLabel(unit);
+
+  if (maxAbsValue > 0.0f)
   {
-    state.stickyMax  = rawMax;
-    state.holdFrames = stickyHoldFrames;
+    const ValuePrefix prefix = findValuePrefix(maxAbsValue);
+    unitLabel = prefix.symbol;
+    unitLabel += unit;
+    if (unitLabel.length() == 0)
+    {
+      unitLabel = unit;
+    }
   }
-  else if (rawMax < state.stickyMax)
+
+  String title = name;
+  title += " (";
+  title += unitLabel;
+  title += ")";
+
+  int16_t titleX = SH1107_WIDTH - (title.length() * 6);
+
+  if (titleX < 0)
   {
-    state.stickyMax += (rawMax - state.stickyMax) * (graphSmoothingAlpha * 0.5f);
+    titleX = 0;
   }
 
-  if (state.holdFrames > 0)
+  m_display.setCursor(titleX, 0);
+  m_display.println(title);
+
+  // axes
+  m_display.drawLine(graphOriginX, graphOriginY, graphOriginX + graphWidth, graphOriginY, SH110X_WHITE);
+  m_display.drawLine(graphOriginX, graphOriginY, graphOriginX, graphOriginY - graphHeight, SH110X_WHITE);
+
+  // y-axis ticks and labels
+  for (uint8_t i = 0; i <= yTickCount; ++i)
   {
-    --state.holdFrames;
+    const float   position = static_cast<float>(i) / yTickCount;
+    const int16_t y        = graphOriginY - static_cast<int16_t>(round(position * graphHeight));
+    const float   value    = minVal + (range * position);
+
+    m_display.drawLine(graphOriginX - 3, y, graphOriginX, y, SH110X_WHITE);
+
+    const ValueText label(value, nullptr, 4);
+    int16_t      textY = y - lineHeight / 2;
+
+    if (textY < 0)
+    {
+      textY = 0;
+    }
+    
+    m_display.setCursor(2, textY);
+    m_display.print(label.c_str());
   }
 }
@@ -6,14 +6,35 @@
 #include <Adafruit_SH110X.h>
 #include <IPAddress.h>
 
-struct InaValues;
+#include "graph_scale.h"
+#include "sh1107_display.h"
+
+struct InaChannel;
+struct MeterReadings;
 class MeasurementHistory;
+class TieredHistory;
+class BurstCapture;
+class TriggerCapture;
+class Profiler;
+class I2cTransferQueue;
 
 enum class DisplayMode
 {
   Summary,
   GraphCurrent,
-  GraphEnergy
+  GraphEnergy,
+  Trigger,
+  Burst
+};
+
+// Time span shown by the graph modes: the raw sample ring or one of the
+// tiers of the long-term history.
+enum class GraphRange
+{
+  Recent,
+  Hour,
+  Day,
+  Week
 };
 
 class DisplayManager
@@ -22,27 +43,45 @@ public:
   DisplayManager();
 
   bool begin();
+  void attachBurst(const BurstCapture *burst);
+  void attachChannels(const InaChannel *channels, size_t count);
+  void attachTrigger(const TriggerCapture *trigger);
+  void attachProfiler(Profiler *profiler);
+
+  // With a queue attached, frames are sent a page per step and busy() holds
+  // until the last page is out; otherwise showMeasurements() blocks for it.
+  void attachBus(I2cTransferQueue *bus);
+  bool busy() const;
   void showConnecting(const char *ssid);
-  void showMeasurements(const InaValues &values, float deltaEnergyWs, bool sensorOk, bool webConnected, const IPAddress &ip,
-                        const MeasurementHistory &history, DisplayMode mode);
+  // `label` names the channel or the total shown, nullptr with one channel;
+  // the tier ranges of the graph always show the total
+  void showMeasurements(const MeterReadings &readings, const char *label, bool webConnected, const IPAddress &ip,
+                        const TieredHistory &tiers, DisplayMode mode, GraphRange range);
 
 private:
-  struct GraphScaleState
-  {
-    float min;
-    float max;
-    float stickyMin;
-    float stickyMax;
-    uint8_t holdFrames;
-    bool    initialized;
-    GraphScaleState() : min(0.0f), max(0.0f), stickyMin(0.0f), stickyMax(0.0f), holdFrames(0), initialized(false) {}
-  };
-
-  void        showGraph(const MeasurementHistory &history, DisplayMode mode);
-  void        updateScaleWithHistory(GraphScaleState &state, const float *values, size_t count);
-
-  Adafruit_SH1107 m_display;
-  bool            m_ready;
-  GraphScaleState m_currentScale;
-  GraphScaleState m_energyScale;
+  struct GraphSeries;
+
+  void        showGraph(const MeasurementHistory &history, const TieredHistory &tiers, DisplayMode mode, GraphRange graphRange);
+  void        showBurst();
+  void        showTrigger();
+  void        drawAlertMarker(bool alignRight);
+  void        drawGraphFrame(const char *name, const char *unit, float minVal, float maxVal);
+  void        flush();
+
+  static bool flushStep(void *context);
+  static void flushDone(void *context);
+
+  Sh1107Display             m_display;
+  bool                      m_ready;
+  GraphScaleState           m_currentScale;
+  GraphScaleState           m_energyScale;
+  GraphRange                m_lastRange;
+  const MeasurementHistory *m_lastHistory;
+  const BurstCapture       *m_burst;
+  const InaChannel         *m_channels;
+  size_t                    m_channelCount;
+  const TriggerCapture     *m_trigger;
+  Profiler                 *m_profiler;
+  I2cTransferQueue         *m_bus;
+  bool                      m_flushing;
 };
@@ -0,0 +1,242 @@
+#include "energy_log.h"
+
+#include <string.h>
+
+#include "telemetry_frame.h"
+
+namespace
+{
+  constexpr char     LOG_DIR[]    = "/energy";
+  constexpr uint16_t RECORD_MAGIC = 0xE1C6;
+
+  constexpr uint32_t MIN_WRITE_INTERVAL_MS = 3600000UL / EnergyLog::kMaxPageWritesPerHour;
+  constexpr uint32_t BUCKET_SECONDS        = TieredHistory::kTiers[0].bucketSeconds;
+
+  constexpr size_t CRC_OFFSET = 4; // magic and crc come first
+}
+
+EnergyLog::EnergyLog()
+    : m_page()
+    , m_pageCount(0)
+    , m_ready(false)
+    , m_firstSegment(0)
+    , m_lastSegment(0)
+    , m_segmentPages(0)
+    , m_nextSequence(0)
+    , m_totalEnergy(0)
+    , m_resumeSeconds(0)
+    , m_restored(0)
+    , m_pageWrites(0)
+    , m_dropped(0)
+    , m_lastWriteMs(0)
+    , m_hasWritten(false)
+{
+  static_assert(sizeof(DiskRecord) == 48, "EnergyLog record layout changed");
+}
+
+bool EnergyLog::begin(TieredHistory &history)
+{
+  if (!LittleFS.begin())
+  {
+    return false;
+  }
+  LittleFS.mkdir(LOG_DIR);
+
+  bool found = false;
+  Dir  dir   = LittleFS.openDir(LOG_DIR);
+  while (dir.next())
+  {
+    const uint32_t segment = static_cast<uint32_t>(dir.fileName().toInt());
+    if (!found || segment < m_firstSegment)
+      m_firstSegment = segment;
+    if (!found || segment > m_lastSegment)
+      m_lastSegment = segment;
+    found = true;
+  }
+
+  m_ready = true;
+  if (found)
+  {
+    for (uint32_t segment = m_firstSegment; segment <= m_lastSegment; ++segment)
+    {
+      restoreSegment(segment, history);
+    }
+  }
+
+  // never append behind a torn record
+  startSegment();
+  return true;
+}
+
+void EnergyLog::restoreSegment(uint32_t segment, TieredHistory &history)
+{
+  File file = LittleFS.open(segmentPath(segment), "r");
+  if (!file)
+  {
+    return;
+  }
+
+  DiskRecord page[kRecordsPerPage];
+  size_t     bytes = 0;
+  while ((bytes = file.read(reinterpret_cast<uint8_t *>(page), sizeof(page))) >= sizeof(DiskRecord))
+  {
+    for (size_t i = 0; i < bytes / sizeof(DiskRecord); ++i)
+    {
+      Record record;
+      if (!decode(page[i], record) || record.sequence < m_nextSequence)
+      {
+        return;
+      }
+
+      history.addBucket(record.bucket);
+      m_nextSequence  = record.sequence + 1;
+      m_totalEnergy   = record.totalEnergy;
+      m_resumeSeconds = record.bucket.startSeconds + BUCKET_SECONDS;
+      ++m_restored;
+    }
+  }
+}
+
+void EnergyLog::startSegment()
+{
+  if (m_restored > 0 || LittleFS.exists(segmentPath(m_lastSegment)))
+  {
+    ++m_lastSegment;
+  }
+  m_segmentPages = 0;
+
+  while (m_lastSegment - m_firstSegment >= kMaxSegments)
+  {
+    LittleFS.remove(segmentPath(m_firstSegment));
+    ++m_firstSegment;
+  }
+}
+
+bool EnergyLog::ready() const
+{
+  return m_ready;
+}
+
+uint32_t EnergyLog::resumeSeconds() const
+{
+  return m_resumeSeconds;
+}
+
+uint64_t EnergyLog::totalEnergy() const
+{
+  return m_totalEnergy;
+}
+
+void EnergyLog::append(const HistoryBucket &bucket)
+{
+  // the flash is behind its write budget: keep the newest records
+  if (m_pageCount == sizeof(m_page) / sizeof(m_page[0]))
+  {
+    memmove(&m_page[0], &m_page[1], sizeof(DiskRecord) * (m_pageCount - 1));
+    --m_pageCount;
+    ++m_dropped;
+  }
+
+  m_totalEnergy += bucket.energy;
+
+  DiskRecord &disk  = m_page[m_pageCount++];
+  disk.magic        = RECORD_MAGIC;
+  disk.sequence     = m_nextSequence++;
+  disk.startSeconds = bucket.startSeconds;
+  disk.samples      = bucket.samples;
+  disk.minCurrent   = bucket.minCurrent;
+  disk.maxCurrent   = bucket.maxCurrent;
+  disk.meanCurrent  = bucket.meanCurrent;
+  disk.reserved     = 0;
+  disk.energy       = bucket.energy;
+  disk.totalEnergy  = m_totalEnergy;
+  disk.crc = telemetry::crc16(reinterpret_cast<const uint8_t *>(&disk) + CRC_OFFSET, sizeof(DiskRecord) - CRC_OFFSET);
+}
+
+bool EnergyLog::writeDue(uint32_t nowMs) const
+{
+  return m_ready && m_pageCount >= kRecordsPerPage && (!m_hasWritten || nowMs - m_lastWriteMs >= MIN_WRITE_INTERVAL_MS);
+}
+
+void EnergyLog::writePage(uint32_t nowMs)
+{
+  if (!writeDue(nowMs))
+  {
+    return;
+  }
+
+  if (m_segmentPages >= kSegmentPages)
+  {
+    startSegment();
+  }
+
+  // counted even if it fails, so a broken flash doesn't get hammered
+  m_lastWriteMs = nowMs;
+  m_hasWritten  = true;
+
+  File file = LittleFS.open(segmentPath(m_lastSegment), "a");
+  if (!file)
+  {
+    return;
+  }
+
+  const size_t pageBytes = sizeof(DiskRecord) * kRecordsPerPage;
+  const bool   written   = file.write(reinterpret_cast<const uint8_t *>(m_page), pageBytes) == pageBytes;
+  file.close();
+
+  if (!written)
+  {
+    // a partial record would end the segment for readers; the page is kept
+    // and retried at the start of a new one
+    startSegment();
+    return;
+  }
+
+  ++m_pageWrites;
+  ++m_segmentPages;
+  m_pageCount -= kRecordsPerPage;
+  memmove(&m_page[0], &m_page[kRecordsPerPage], sizeof(DiskRecord) * m_pageCount);
+}
+
+uint32_t EnergyLog::restoredRecords() const
+{
+  return m_restored;
+}
+
+uint32_t EnergyLog::pageWrites() const
+{
+  return m_pageWrites;
+}
+
+uint32_t EnergyLog::droppedRecords() const
+{
+  return m_dropped;
+}
+
+bool EnergyLog::decode(const DiskRecord &disk, Record &record)
+{
+  if (disk.magic != RECORD_MAGIC ||
+      disk.crc != telemetry::crc16(reinterpret_cast<const uint8_t *>(&disk) + CRC_OFFSET, sizeof(DiskRecord) - CRC_OFFSET))
+  {
+    return false;
+  }
+
+  record.sequence            = disk.sequence;
+  record.bucket.startSeconds = disk.startSeconds;
+  record.bucket.samples      = disk.samples;
+  record.bucket.minCurrent   = disk.minCurrent;
+  record.bucket.maxCurrent   = disk.maxCurrent;
+  record.bucket.meanCurrent  = disk.meanCurrent;
+  record.bucket.energy       = disk.energy;
+  record.totalEnergy         = disk.totalEnergy;
+  return true;
+}
+
+String EnergyLog::segmentPath(uint32_t segment)
+{
+  String path(LOG_DIR);
+  path += '/';
+  path += segment;
+  path += ".bin";
+  return path;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#include "tiered_history.h"
+
+// Persistent log of the closed one-minute buckets of TieredHistory, so a reset
+// or brownout keeps the history and the lifetime energy total.
+//
+// Records are CRC-protected and collected in a RAM page; only whole pages are
+// appended to flash, at most kMaxPageWritesPerHour of them. The log is split
+// into fixed-size segment files and the oldest segment is deleted once there
+// are kMaxSegments, so the used space is bounded and LittleFS can spread the
+// erases over the whole partition. Times are meter seconds: uptime continued
+// from the last logged bucket, downtime is not counted.
+class EnergyLog
+{
+public:
+  static constexpr size_t   kRecordsPerPage       = 5;
+  static constexpr size_t   kSegmentPages         = 32; // 7.5 KB, 160 minutes per file
+  static constexpr uint32_t kMaxSegments          = 64; // ~7 days, the week tier
+  static constexpr uint32_t kMaxPageWritesPerHour = 20;
+
+  struct Record
+  {
+    uint32_t      sequence; // counts records since the log was created
+    HistoryBucket bucket;
+    uint64_t      totalEnergy; // lifetime ENERGY counts up to the end of the bucket
+  };
+
+  EnergyLog();
+
+  // Mounts LittleFS and replays the retained records into `history`.
+  bool begin(TieredHistory &history);
+  bool ready() const;
+
+  // Meter time at which the restored history continues.
+  uint32_t resumeSeconds() const;
+
+  // Lifetime energy in ENERGY counts, up to the last appended bucket.
+  uint64_t totalEnergy() const;
+
+  void append(const HistoryBucket &bucket);
+
+  // A full page is waiting and the write budget allows it.
+  bool writeDue(uint32_t nowMs) const;
+  void writePage(uint32_t nowMs);
+
+  uint32_t restoredRecords() const;
+  uint32_t pageWrites() const;
+  uint32_t droppedRecords() const;
+
+  // Streams the records with sequence >= `since` from flash, oldest first, a
+  // page at a time; the RAM page is not included. The visitor returns false
+  // to stop. A torn record ends its segment, later segments are still read.
+  template <typename Visitor>
+  void forEachRecord(uint32_t since, Visitor &&visit) const
+  {
+    for (uint32_t segment = m_firstSegment; m_ready && segment <= m_lastSegment; ++segment)
+    {
+      File file = LittleFS.open(segmentPath(segment), "r");
+      if (!file)
+        continue;
+
+      DiskRecord page[kRecordsPerPage];
+      size_t     bytes = 0;
+      bool       valid = true;
+      while (valid && (bytes = file.read(reinterpret_cast<uint8_t *>(page), sizeof(page))) >= sizeof(DiskRecord))
+      {
+        for (size_t i = 0; valid && i < bytes / sizeof(DiskRecord); ++i)
+        {
+          Record record;
+          valid = decode(page[i], record);
+          if (valid && record.sequence >= since && !visit(record))
+            return;
+        }
+      }
+    }
+  }
+
+private:
+  // 48 bytes on flash, little-endian as in memory
+  struct DiskRecord
+  {
+    uint16_t magic;
+    uint16_t crc; // CRC-16/CCITT-FALSE over the bytes after this field
+    uint32_t sequence;
+    uint32_t startSeconds;
+    uint32_t samples;
+    int32_t  minCurrent;
+    int32_t  maxCurrent;
+    int32_t  meanCurrent;
+    uint32_t reserved;
+    uint64_t energy;
+    uint64_t totalEnergy;
+  };
+
+  static bool   decode(const DiskRecord &disk, Record &record);
+  static String segmentPath(uint32_t segment);
+
+  void restoreSegment(uint32_t segment, TieredHistory &history);
+  void startSegment();
+
+  DiskRecord m_page[kRecordsPerPage * 2]; // one page being written, one filling
+  size_t     m_pageCount;
+  bool       m_ready;
+  uint32_t   m_firstSegment;
+  uint32_t   m_lastSegment;
+  size_t     m_segmentPages; // pages in the last segment
+  uint32_t   m_nextSequence;
+  uint64_t   m_totalEnergy;
+  uint32_t   m_resumeSeconds;
+  uint32_t   m_restored;
+  uint32_t   m_pageWrites;
+  uint32_t   m_dropped;
+  uint32_t   m_lastWriteMs;
+  bool       m_hasWritten;
+};
@@ -0,0 +1,218 @@
+#include "ina228_reader.h"
+
+namespace
+{
+  constexpr uint8_t REG_ADC_CONFIG = 0x01;
+  constexpr uint8_t REG_SHUNT_CAL  = 0x02;
+  constexpr uint8_t REG_VSHUNT     = 0x04;
+  constexpr uint8_t REG_VBUS       = 0x05;
+  constexpr uint8_t REG_DIETEMP    = 0x06;
+  constexpr uint8_t REG_CURRENT    = 0x07;
+  constexpr uint8_t REG_ENERGY     = 0x09;
+  constexpr uint8_t REG_CHARGE     = 0x0A;
+  constexpr uint8_t REG_DIAG_ALRT  = 0x0B;
+  constexpr uint8_t REG_SOVL       = 0x0C;
+  constexpr uint8_t REG_SUVL       = 0x0D;
+  constexpr uint8_t REG_BOVL       = 0x0E;
+  constexpr uint8_t REG_BUVL       = 0x0F;
+  constexpr uint8_t REG_TEMP_LIMIT = 0x10;
+  constexpr uint8_t REG_PWR_LIMIT  = 0x11;
+
+  constexpr double  SHUNT_CAL = 13107.2e6 * ina::kCurrentLsbA * ina::kShuntOhms * (ina::kLowAdcRange ? 4.0 : 1.0);
+  static_assert(SHUNT_CAL < 32768.0, "SHUNT_CAL is a 15-bit register");
+
+  // die temperature changes slowly, so it is only fetched every n-th sample
+  constexpr uint8_t TEMPERATURE_DECIMATION = 16;
+
+  int32_t decode20(const uint8_t *data)
+  {
+    int32_t value = (static_cast<int32_t>(data[0]) << 16) | (static_cast<int32_t>(data[1]) << 8) | data[2];
+    value >>= 4;
+    if (value & 0x80000)
+    {
+      value -= 0x100000;
+    }
+    return value;
+  }
+
+  uint64_t decode40(const uint8_t *data)
+  {
+    uint64_t value = 0;
+    for (uint8_t i = 0; i < 5; ++i)
+    {
+      value = (value << 8) | data[i];
+    }
+    return value;
+  }
+}
+
+Ina228Reader::Ina228Reader()
+    : m_wire(nullptr)
+    , m_address(0)
+    , m_diagAlert(0)
+    , m_tempCountdown(0)
+    , m_lastDieTemp(0)
+{
+}
+
+bool Ina228Reader::begin(TwoWire &wire, uint8_t address)
+{
+  m_wire    = &wire;
+  m_address = address;
+
+  return writeRegister16(REG_SHUNT_CAL, static_cast<uint16_t>(SHUNT_CAL + 0.5));
+}
+
+bool Ina228Reader::read(InaValues &values)
+{
+  uint16_t diag = 0;
+  return readDiagAlert(diag) && readValues(values);
+}
+
+bool Ina228Reader::readDiagAlert(uint16_t &diag)
+{
+  uint8_t data[2];
+  if (m_wire == nullptr || !readRegister(REG_DIAG_ALRT, data, 2))
+  {
+    return false;
+  }
+  m_diagAlert = (static_cast<uint16_t>(data[0]) << 8) | data[1];
+  diag        = m_diagAlert;
+  return true;
+}
+
+bool Ina228Reader::readValues(InaValues &values)
+{
+  if (m_wire == nullptr)
+  {
+    return false;
+  }
+
+  uint8_t data[5];
+
+  if (!readRegister(REG_VSHUNT, data, 3))
+    return false;
+  values.vShunt = decode20(data);
+
+  if (!readRegister(REG_VBUS, data, 3))
+    return false;
+  values.vBus = decode20(data);
+
+  if (!readRegister(REG_CURRENT, data, 3))
+    return false;
+  values.current = decode20(data);
+
+  if (!readRegister(REG_ENERGY, data, 5))
+    return false;
+  values.energy = decode40(data);
+
+  if (!readRegister(REG_CHARGE, data, 5))
+    return false;
+  values.charge = static_cast<int64_t>(decode40(data));
+  if (values.charge & (1LL << 39))
+  {
+    values.charge -= (1LL << 40);
+  }
+
+  if (m_tempCountdown == 0)
+  {
+    if (!readRegister(REG_DIETEMP, data, 2))
+      return false;
+    m_lastDieTemp   = static_cast<int16_t>((static_cast<uint16_t>(data[0]) << 8) | data[1]);
+    m_tempCountdown = TEMPERATURE_DECIMATION;
+  }
+  --m_tempCountdown;
+  values.dieTemp = m_lastDieTemp;
+
+  return true;
+}
+
+bool Ina228Reader::clearAlert()
+{
+  uint8_t data[2];
+  return (m_wire != nullptr) && readRegister(REG_DIAG_ALRT, data, 2);
+}
+
+bool Ina228Reader::writeLimits(const ina::AlertLimits &limits)
+{
+  return (m_wire != nullptr) && writeRegister16(REG_SOVL, static_cast<uint16_t>(limits.shuntOver)) &&
+         writeRegister16(REG_SUVL, static_cast<uint16_t>(limits.shuntUnder)) && writeRegister16(REG_BOVL, limits.busOver) &&
+         writeRegister16(REG_BUVL, limits.busUnder) && writeRegister16(REG_TEMP_LIMIT, static_cast<uint16_t>(limits.tempOver)) &&
+         writeRegister16(REG_PWR_LIMIT, limits.powerOver);
+}
+
+bool Ina228Reader::readAdcConfig(uint16_t &config)
+{
+  uint8_t data[2];
+  if (m_wire == nullptr || !readRegister(REG_ADC_CONFIG, data, 2))
+  {
+    return false;
+  }
+  config = (static_cast<uint16_t>(data[0]) << 8) | data[1];
+  return true;
+}
+
+bool Ina228Reader::writeAdcConfig(uint16_t config)
+{
+  return (m_wire != nullptr) && writeRegister16(REG_ADC_CONFIG, config);
+}
+
+bool Ina228Reader::readCurrentIfReady(int32_t &current, bool &ready)
+{
+  ready = false;
+  if (m_wire == nullptr)
+  {
+    return false;
+  }
+
+  uint8_t data[3];
+  if (!readRegister(REG_DIAG_ALRT, data, 2))
+    return false;
+  m_diagAlert = (static_cast<uint16_t>(data[0]) << 8) | data[1];
+
+  if ((m_diagAlert & ina::kDiagConversionDone) == 0)
+  {
+    return true;
+  }
+
+  if (!readRegister(REG_CURRENT, data, 3))
+    return false;
+  current = decode20(data);
+  ready   = true;
+  return true;
+}
+
+uint16_t Ina228Reader::lastDiagAlert() const
+{
+  return m_diagAlert;
+}
+
+bool Ina228Reader::readRegister(uint8_t reg, uint8_t *data, uint8_t length)
+{
+  m_wire->beginTransmission(m_address);
+  m_wire->write(reg);
+  if (m_wire->endTransmission(false) != 0)
+  {
+    return false;
+  }
+
+  if (m_wire->requestFrom(m_address, length) != length)
+  {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < length; ++i)
+  {
+    data[i] = static_cast<uint8_t>(m_wire->read());
+  }
+  return true;
+}
+
+bool Ina228Reader::writeRegister16(uint8_t reg, uint16_t value)
+{
+  m_wire->beginTransmission(m_address);
+  m_wire->write(reg);
+  m_wire->write(static_cast<uint8_t>(value >> 8));
+  m_wire->write(static_cast<uint8_t>(value & 0xFF));
+  return m_wire->endTransmission() == 0;
+}
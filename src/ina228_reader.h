@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "ina_values.h"
+
+// Acquisition path that bypasses the Adafruit driver for the per-sample reads:
+// each register is fetched with a single pointer write + repeated-start read and
+// kept as the raw integer code. The Adafruit driver is still used for setup.
+class Ina228Reader
+{
+public:
+  Ina228Reader();
+
+  // Programs SHUNT_CAL to match the compile-time ina::CurrentScale.
+  bool begin(TwoWire &wire, uint8_t address);
+
+  // Reads DIAG_ALRT first (clearing CNVRF so the next conversion raises a new
+  // alert), then the measurement registers.
+  bool read(InaValues &values);
+  bool clearAlert();
+
+  // The two halves of read(), for callers that look at the flags first.
+  bool readDiagAlert(uint16_t &diag);
+  bool readValues(InaValues &values);
+
+  // SOVL/SUVL, BOVL/BUVL, TEMP_LIMIT and PWR_LIMIT in one go.
+  bool writeLimits(const ina::AlertLimits &limits);
+
+  // ADC_CONFIG: MODE[15:12] VBUSCT[11:9] VSHCT[8:6] VTCT[5:3] AVG[2:0]
+  static constexpr uint16_t adcConfig(uint8_t mode, uint8_t busTime, uint8_t shuntTime, uint8_t tempTime, uint8_t averaging)
+  {
+    return static_cast<uint16_t>((mode & 0xF) << 12 | (busTime & 0x7) << 9 | (shuntTime & 0x7) << 6 | (tempTime & 0x7) << 3 |
+                                 (averaging & 0x7));
+  }
+
+  bool readAdcConfig(uint16_t &config);
+  bool writeAdcConfig(uint16_t config);
+
+  // Fast path for burst capture: polls DIAG_ALRT and fetches only CURRENT
+  // once a new conversion is ready. `ready` is false if none was pending.
+  bool readCurrentIfReady(int32_t &current, bool &ready);
+
+  uint16_t lastDiagAlert() const;
+
+private:
+  bool readRegister(uint8_t reg, uint8_t *data, uint8_t length);
+  bool writeRegister16(uint8_t reg, uint16_t value);
+
+  TwoWire *m_wire;
+  uint8_t  m_address;
+  uint16_t m_diagAlert;
+  uint8_t  m_tempCountdown;
+  int16_t  m_lastDieTemp;
+};
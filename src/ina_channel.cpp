@@ -0,0 +1,46 @@
+#include "ina_channel.h"
+
+#include <Adafruit_INA228.h>
+
+bool InaChannel::begin(const InaChannelConfig &channelConfig, Adafruit_INA228 &driver, TwoWire &wire)
+{
+  config = &channelConfig;
+  ready  = false;
+
+  if (config->address < kInaFirstAddress || config->address > kInaLastAddress || !driver.begin(config->address, &wire))
+  {
+    return false;
+  }
+
+  driver.setADCRange(ina::kLowAdcRange ? 1 : 0);
+  driver.setAlertPolarity(INA228_ALERT_POLARITY_INVERTED);
+  driver.setAlertLatch(INA228_ALERT_LATCH_TRANSPARENT);
+  driver.setAlertType(INA228_ALERT_CONVERSION_READY);
+  ready = reader.begin(wire, config->address) && reader.writeAdcConfig(config->adcConfig) &&
+          reader.writeLimits(config->limits);
+  driver.resetAccumulators();
+  return ready;
+}
+
+InaValues sumChannels(const InaChannel *channels, size_t count)
+{
+  InaValues total = {};
+  bool      first = true;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const MeterReadings &readings = channels[i].readings;
+    if (!readings.ok)
+      continue;
+
+    total.vShunt += readings.values.vShunt;
+    total.current += readings.values.current;
+    total.energy += readings.values.energy;
+    total.charge += readings.values.charge;
+    if (first || readings.values.vBus > total.vBus)
+      total.vBus = readings.values.vBus;
+    if (first || readings.values.dieTemp > total.dieTemp)
+      total.dieTemp = readings.values.dieTemp;
+    first = false;
+  }
+  return total;
+}
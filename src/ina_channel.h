@@ -0,0 +1,65 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "alert_events.h"
+#include "ina228_reader.h"
+#include "ina_values.h"
+#include "measurement_history.h"
+#include "sample_timing.h"
+
+class Adafruit_INA228;
+
+// Up to 16 INA228s share the bus; A0/A1 select 0x40..0x4F.
+constexpr uint8_t kInaFirstAddress = 0x40;
+constexpr uint8_t kInaLastAddress  = 0x4F;
+constexpr int8_t  kInaPolled       = -1; // no ALERT line, DIAG_ALRT is polled
+
+// Settings of one INA228. The shunt and the ADC range are common to all
+// channels (ina_values.h), so raw codes of different channels add up.
+struct InaChannelConfig
+{
+  const char      *name;      // shown by the display and the web views
+  uint8_t          address;
+  int8_t           alertPin;  // GPIO wired to ALERT, or kInaPolled
+  uint16_t         adcConfig; // Ina228Reader::adcConfig()
+  uint16_t         pollMs;    // DIAG_ALRT poll interval without ALERT line
+  ina::AlertLimits limits;
+};
+
+// The latest sample and the recent samples of one channel or of the total.
+struct MeterReadings
+{
+  InaValues          values      = {};
+  uint64_t           energyDelta = 0;
+  bool               ok          = false;
+  MeasurementHistory history;
+};
+
+// Acquisition state of one INA228. Edges are pushed by its ALERT interrupt;
+// everything else belongs to the main loop.
+struct InaChannel
+{
+  const InaChannelConfig *config     = nullptr;
+  Ina228Reader            reader;
+  bool                    ready      = false;
+  uint32_t                lastPollMs = 0;
+  EdgeTimestampRing<8>    alertEdges; // micros() of every ALERT edge
+  SampleTiming            timing;
+  AlertEventLog           alerts;
+  MeterReadings           readings;
+
+  // Configures the sensor through `driver`, then programs the limits and
+  // SHUNT_CAL through the reader.
+  bool begin(const InaChannelConfig &channelConfig, Adafruit_INA228 &driver, TwoWire &wire);
+
+  bool polled() const
+  {
+    return config->alertPin == kInaPolled;
+  }
+};
+
+// Sum of the latest samples of the channels that are ok. Bus voltage and die
+// temperature don't add up; the total carries the highest of each.
+InaValues sumChannels(const InaChannel *channels, size_t count);
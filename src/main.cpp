@@ -4,47 +4,123 @@
 
 #include "secrets.h"
 #include "ina_values.h"
-#include "value_format.h"
+#include "alert_events.h"
+#include "burst_capture.h"
+#include "compressed_history.h"
 #include "display_manager.h"
+#include "energy_log.h"
+#include "i2c_transfer_queue.h"
+#include "ina_channel.h"
 #include "measurement_history.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include "serial_logger.h"
+#include "telemetry_stream.h"
+#include "tiered_history.h"
+#include "trigger_capture.h"
 #include "webinterface.h"
 
 constexpr int SDA_PIN = D2;
 constexpr int SCL_PIN = D1;
 
-constexpr uint8_t INA228_ADDR       = 0x40;   // A0 = GND
-constexpr float   INA228_SHUNT_OHMS = 0.05;   // shunt resistance
 constexpr uint8_t BUTTON_PIN        = 0;      // GPIO0
 constexpr uint8_t INA_ALERT_PIN     = D5;     // GPIO14
 
 constexpr unsigned long BUTTON_DEBOUNCE_MS      = 50;
+constexpr unsigned long BUTTON_LONG_PRESS_MS    = 800;
 constexpr unsigned long WEB_LOOP_INTERVAL_MS    = 10;
+constexpr unsigned long BUTTON_POLL_MS          = 5;
+constexpr unsigned long TASK_REPORT_MS          = 60000;
+constexpr unsigned long LIMIT_POLL_MS           = 10;
+constexpr LogLevel      LOG_LEVEL               = LogLevel::Debug;
+
+// Text: human-readable log lines. Binary: one COBS frame per sample with the
+// raw registers (include/telemetry_frame.h), decoded by tools_telemetry_decoder.
+enum class SerialOutput
+{
+  Text,
+  Binary
+};
+constexpr SerialOutput SERIAL_OUTPUT = SerialOutput::Text;
+
+// Hardware limits, checked by the INA228 on every conversion. Unset fields keep
+// the power-on values, which never trip.
+constexpr ina::AlertLimits makeInaLimits()
+{
+  ina::AlertLimits limits;
+  limits.shuntOver  = ina::shuntLimitCode(0.75);  // A, overcurrent
+  limits.shuntUnder = ina::shuntLimitCode(-0.05); // A, reverse current
+  limits.busOver    = ina::busLimitCode(5.5);     // V
+  limits.powerOver  = ina::powerLimitCode(3.5);   // W
+  return limits;
+}
+constexpr ina::AlertLimits INA_LIMITS = makeInaLimits();
+
+// continuous bus, shunt and temperature conversions: 4120 us, 4120 us and
+// 1052 us, averaged over 256, about one sample every 2.4 s
+constexpr uint16_t INA_ADC_CONFIG = Ina228Reader::adcConfig(INA228_MODE_CONTINUOUS, INA228_TIME_4120_us, INA228_TIME_4120_us,
+                                                            INA228_TIME_1052_us, INA228_COUNT_256);
+
+// One entry per INA228 on the bus, about 4 KB of RAM each. Shunt and ADC
+// range: see ina_values.h. Burst capture runs on the first channel. A channel
+// without ALERT line is polled, and its samples carry the time of the poll.
+// The bus takes 16 addresses, but RAM takes 3 channels at most. That is also
+// the number of free GPIOs that can take an ALERT line: D5, D6 and D7.
+// GPIO0, 2 and 15 are boot straps and GPIO16 has no interrupt.
+constexpr InaChannelConfig INA_CHANNELS[] = {
+    // name, address, ALERT pin, ADC_CONFIG, poll [ms], limits
+    { "main", 0x40, INA_ALERT_PIN, INA_ADC_CONFIG, 0, INA_LIMITS }, // A0 = A1 = GND
+};
+constexpr size_t INA_CHANNEL_COUNT = sizeof(INA_CHANNELS) / sizeof(INA_CHANNELS[0]);
+static_assert(INA_CHANNEL_COUNT >= 1 && INA_CHANNEL_COUNT <= 3, "1 to 3 INA228 channels fit in RAM");
+
+// Armed at boot; re-armed by a long press in the trigger view or over HTTP.
+constexpr float    TRIGGER_LEVEL_A      = 0.5f;
+constexpr uint16_t TRIGGER_PRE_SAMPLES  = 32;
+constexpr uint16_t TRIGGER_POST_SAMPLES = 64;
 
 // 0.05 Ohm shunt
 // Resolution: LSB=6.25uA  for ADCRANGE=0 and LSB=1.56uA  for ADCRANGE=1
 // Saturates:  MAX=3.2768A for ADCRANGE=0 and MAX=0.8192A for ADCRANGE=1
 
 
-Adafruit_INA228    ina228;
-bool               inaReady = false;
-
-volatile uint32_t  inaAlertCount      = 0;
-InaValues          lastMeasuredValues = {};
-bool               lastMeasurementOk  = false;
-float              lastEnergyDeltaWs  = 0.0f;
+Adafruit_INA228    ina228; // setup only, once per channel
+InaChannel         channels[INA_CHANNEL_COUNT];
+size_t             nextChannel        = 0; // round-robin start of the next acquisition
+uint16_t           freshChannels      = 0; // bit per channel sampled since the last total
+uint64_t           pendingEnergyDelta = 0; // energy of those samples
+MeterReadings      totalReadings;
 
 WebInterface       webInterface;
 IPAddress          webIp;
 bool               webConnected = false;
 DisplayManager     displayManager;
-MeasurementHistory measurementHistory;
-DisplayMode        displayMode = DisplayMode::Summary;
+SampleArchive      sampleArchive;
+TieredHistory      tieredHistory;
+EnergyLog          energyLog;
+uint32_t           meterTimeBase = 0; // meter seconds at boot, continued from the energy log
+uint32_t           loggedBuckets = 0;
+DisplayMode        displayMode    = DisplayMode::Summary;
+GraphRange         graphRange     = GraphRange::Recent;
+size_t             displayChannel = INA_CHANNEL_COUNT; // INA_CHANNEL_COUNT = total
+
+Scheduler          scheduler;
+I2cTransferQueue   i2cTransfers; // display pages, interleaved with the sensor reads
+Profiler           profiler;
+SerialLogger       logger;
+TelemetryStream    telemetryStream;
+BurstCapture       burstCapture;
+TriggerCapture     triggerCapture;
+size_t             burstDumpIndex = BurstCapture::kCapacity; // next sample to log, kCapacity = done
+bool               displayPending = false; // new sample or mode change to draw
 
 void handleButton()
 {
   static bool           lastReading     = HIGH;
   static bool           stableState     = HIGH;
   static unsigned long  lastChangeTime  = 0;
+  static unsigned long  pressStartTime  = 0;
+  static bool           longPressFired  = false;
 
   const bool            reading         = digitalRead(BUTTON_PIN);
   const unsigned long   now             = millis();
@@ -59,6 +135,12 @@ void handleButton()
     stableState = reading;
     if (stableState == LOW)
     {
+      pressStartTime = now;
+      longPressFired = false;
+    }
+    else if (!longPressFired)
+    {
+      // short press: cycle display mode
       switch (displayMode)
       {
         case DisplayMode::Summary:
@@ -68,179 +150,549 @@ void handleButton()
           displayMode = DisplayMode::GraphEnergy;
           break;
         case DisplayMode::GraphEnergy:
+          displayMode = DisplayMode::Trigger;
+          break;
+        case DisplayMode::Trigger:
+          displayMode = DisplayMode::Burst;
+          break;
+        case DisplayMode::Burst:
           displayMode = DisplayMode::Summary;
           break;
       }
+      displayPending = true;
     }
   }
 
+  // long press: cycle the history range shown by the graph modes, the channel
+  // shown by the summary, or start a new capture while the trigger or burst
+  // view is shown
+  if (stableState == LOW && !longPressFired && (now - pressStartTime) >= BUTTON_LONG_PRESS_MS)
+  {
+    longPressFired = true;
+    if (displayMode == DisplayMode::Summary && INA_CHANNEL_COUNT > 1)
+    {
+      displayChannel = (displayChannel + 1) % (INA_CHANNEL_COUNT + 1);
+    }
+    else if (displayMode == DisplayMode::Trigger)
+    {
+      triggerCapture.arm(triggerCapture.config());
+    }
+    else if (displayMode == DisplayMode::Burst)
+    {
+      burstCapture.request();
+    }
+    else
+    {
+      switch (graphRange)
+      {
+        case GraphRange::Recent:
+          graphRange = GraphRange::Hour;
+          break;
+        case GraphRange::Hour:
+          graphRange = GraphRange::Day;
+          break;
+        case GraphRange::Day:
+          graphRange = GraphRange::Week;
+          break;
+        case GraphRange::Week:
+          graphRange = GraphRange::Recent;
+          break;
+      }
+    }
+    displayPending = true;
+  }
+
   lastReading = reading;
 }
 
-bool readInaValues(InaValues &values)
+void IRAM_ATTR onInaAlert(void *channel)
 {
-  if (!inaReady)
+  static_cast<InaChannel *>(channel)->alertEdges.push(micros());
+}
+
+void recordAlert(InaChannel &channel, uint32_t timestampUs, uint16_t flags, const InaValues &values)
+{
+  AlertEvent event;
+  event.timestampUs = timestampUs;
+  event.timestampMs = millis();
+  event.flags       = flags;
+  event.current     = values.current;
+  event.vBus        = values.vBus;
+  channel.alerts.add(event);
+
+  AlertLog record;
+  record.number = channel.alerts.total();
+  record.event  = event;
+  logger.logAlert(record);
+}
+
+void pushTriggerSample(const InaValues &values, uint32_t timestampMs)
+{
+  const uint32_t captures = triggerCapture.captureId();
+  triggerCapture.push({ timestampMs, values.current, values.vBus });
+
+  if (triggerCapture.captureId() != captures)
   {
-    return false;
+    logger.logMessage(LogLevel::Info, F("Trigger captured"));
+    displayMode = DisplayMode::Trigger;
   }
+}
 
-  values.vShunt      = ina228.readShuntVoltage() / 1000.0f;
-  values.vBus        = ina228.readBusVoltage();
-  values.temperature = ina228.readDieTemp();
-  values.current_mA  = ina228.getCurrent_mA();
-  values.energyWs    = ina228.readEnergy();
+// every closed one-minute bucket goes to flash, batched by the energy log
+void logClosedBuckets()
+{
+  const uint32_t                closed  = tieredHistory.closedCount(HistoryTier::Hour);
+  const RingView<HistoryBucket> buckets = tieredHistory.buckets(HistoryTier::Hour);
+
+  for (; loggedBuckets != closed; ++loggedBuckets)
+  {
+    const uint32_t pending = closed - loggedBuckets;
+    if (pending <= buckets.size())
+    {
+      energyLog.append(buckets[buckets.size() - pending]);
+    }
+  }
+}
 
-  return true;
+void reportReadError(InaChannel &channel)
+{
+  channel.readings.ok = false;
+  totalReadings.ok    = false;
+  displayPending      = true;
+  logger.logMessage(LogLevel::Error, F("Error reading INA228"));
 }
 
-void IRAM_ATTR onInaAlert()
+// Once every channel that is ok has a new sample, their sum becomes the next
+// sample of the total, which feeds the long-term history, the archive, the
+// trigger and the serial output.
+void publishTotal(uint32_t nowMs, uint32_t nowUs)
 {
-  ++inaAlertCount;
+  totalReadings.values      = sumChannels(channels, INA_CHANNEL_COUNT);
+  totalReadings.energyDelta = pendingEnergyDelta;
+  totalReadings.ok          = true;
+  freshChannels             = 0;
+  pendingEnergyDelta        = 0;
+
+  const InaValues &values = totalReadings.values;
+
+  ProfileScope historyUpdate(&profiler, ProfileStage::History);
+  totalReadings.history.addMeasurement(values, nowMs);
+  sampleArchive.add(values, nowMs);
+  pushTriggerSample(values, nowMs);
+  tieredHistory.addSample(values.current, totalReadings.energyDelta, meterTimeBase + nowMs / 1000UL);
+  logClosedBuckets();
+  historyUpdate.finish();
+  webInterface.updateMeasurements(values);
+
+  // only a binary record here; formatting and UART output happen in drainLog()
+  if (SERIAL_OUTPUT == SerialOutput::Binary)
+  {
+    telemetry::Sample sample;
+    sample.sequence    = totalReadings.history.nextSequence() - 1;
+    sample.timestampUs = nowUs;
+    sample.values      = values;
+    telemetryStream.publish(sample);
+  }
+  else if (logger.enabled(LogLevel::Info))
+  {
+    MeasurementLog record = {};
+    record.count          = totalReadings.history.count();
+    record.vBus           = values.vBus;
+    record.vShunt         = values.vShunt;
+    record.current        = values.current;
+    record.energy         = values.energy;
+    record.dieTemp        = values.dieTemp;
+    record.hasStats       = record.count >= 2;
+    if (record.hasStats)
+    {
+      ProfileScope                           statsScope(&profiler, ProfileStage::Stats);
+      const MeasurementHistory::CurrentStats stats = totalReadings.history.getCurrentStats();
+      statsScope.finish();
+      record.range        = stats.maxCurrent - stats.minCurrent;
+      record.mean         = stats.meanCurrent;
+      record.stdDeviation = stats.stdDeviation;
+    }
+    logger.logMeasurement(record);
+  }
 }
 
-void processInaAlerts()
+// ALERT is shared by conversion-ready and the limit comparators; DIAG_ALRT
+// tells which one fired. Samples and events carry the time of the newest
+// interrupt, not the time they were serviced.
+void processChannel(size_t index)
 {
-  if (!inaReady)
+  InaChannel &channel = channels[index];
+
+  uint32_t       alertUs = 0;
+  const uint32_t alerts  = channel.alertEdges.drain(
+      [&](uint32_t lost) { channel.timing.addLostStamps(lost); },
+      [&](uint32_t timestampUs)
+      {
+        channel.timing.addEdge(timestampUs);
+        alertUs = timestampUs;
+      });
+
+  channel.lastPollMs = millis();
+
+  uint16_t       diag   = 0;
+  InaValues      values{};
+  const uint32_t diagUs = micros();
+  ProfileScope   diagRead(&profiler, ProfileStage::InaRead);
+  const bool     diagOk = channel.reader.readDiagAlert(diag);
+  diagRead.finish();
+  if (!diagOk)
   {
+    reportReadError(channel);
     return;
   }
 
-  uint32_t alerts = 0;
-  noInterrupts();
-  alerts        = inaAlertCount;
-  inaAlertCount = 0;
-  interrupts();
-
-  if (alerts == 0)
+  const AlertRead read = channel.alerts.update(diag, alerts != 0, alertUs, diagUs);
+  if (!read.converted && !read.event)
   {
     return;
   }
 
   // INA228 doesn't buffer multiple conversions, so one read gets latest data.
-  InaValues values{};
-  if (!readInaValues(values))
+  ProfileScope valuesRead(&profiler, ProfileStage::InaRead);
+  const bool   valuesOk = channel.reader.readValues(values);
+  valuesRead.finish();
+  if (!valuesOk)
   {
-    lastMeasurementOk = false;
-    Serial.println(F("Error reading INA228"));
-    ina228.alertFunctionFlags();
+    reportReadError(channel);
+    channel.reader.clearAlert();
     return;
   }
 
-  const unsigned long nowMs          = millis();
-  const float         prevEnergyWs   = lastMeasuredValues.energyWs;
-  lastMeasuredValues                 = values;
-  lastEnergyDeltaWs                  = max(lastMeasuredValues.energyWs - prevEnergyWs, 0.0f);
-  lastMeasurementOk                  = true;
+  if (read.event)
+  {
+    recordAlert(channel, read.edge ? alertUs : micros(), read.newFlags, values);
+    displayPending = true;
+  }
 
-  measurementHistory.addMeasurement(lastMeasuredValues.current_mA, lastMeasuredValues.energyWs, static_cast<float>(nowMs) / 1000.0f);
+  if (!read.converted)
+  {
+    return;
+  }
 
-  size_t historyCount = measurementHistory.count();
-  if (historyCount >= 2)
+  // the conversion finished at the edge; polled samples only have the read time
+  const uint32_t readUs      = micros();
+  const uint32_t latencyUs   = read.edge ? readUs - alertUs : 0;
+  const uint32_t nowUs       = readUs - latencyUs;
+  const uint32_t nowMs       = millis() - latencyUs / 1000UL;
+  MeterReadings &readings    = channel.readings;
+  const uint64_t prevEnergy  = readings.values.energy;
+  readings.values            = values;
+  readings.energyDelta       = (values.energy >= prevEnergy) ? values.energy - prevEnergy : 0; // accumulator reset
+  readings.ok                = true;
+  readings.history.addMeasurement(values, nowMs);
+  if (read.edge)
   {
-    MeasurementHistory::CurrentStats stats = measurementHistory.getCurrentStats();
-    const float fluctuation_mA = stats.maxCurrent - stats.minCurrent; // mA
-    const float stdDev_mA      = stats.stdDeviation; // mA
-    const float mean_mA        = stats.meanCurrent; // mA
+    // a newly raised limit accounts for one of the edges, not a conversion
+    const uint32_t limitEdges = (read.newFlags != 0) ? 1 : 0;
+    channel.timing.addService(alerts - limitEdges, latencyUs);
+  }
+
+  freshChannels |= static_cast<uint16_t>(1U << index);
+  pendingEnergyDelta += readings.energyDelta;
 
-    const float stdDevPercent = (mean_mA > 0.0f) ? (stdDev_mA / mean_mA) * 100.0f : 0.0f;
-    const float rangePercent  = (mean_mA > 0.0f) ? (fluctuation_mA / mean_mA) * 100.0f : 0.0f;
+  uint16_t live = 0;
+  for (size_t i = 0; i < INA_CHANNEL_COUNT; ++i)
+  {
+    if (channels[i].ready && channels[i].readings.ok)
+      live |= static_cast<uint16_t>(1U << i);
+  }
+  if ((freshChannels & live) == live)
+  {
+    publishTotal(nowMs, nowUs);
+  }
+
+  // drawing runs as a separate, lower-priority task
+  displayPending = true;
+}
+
+// A violation that persists holds ALERT asserted and hides the conversion-ready
+// edges, so the flags are polled until it clears. Channels without ALERT line
+// are polled all the time.
+bool channelDue(const InaChannel &channel, uint32_t nowMs)
+{
+  if (!channel.ready)
+  {
+    return false;
+  }
+
+  const uint32_t sincePoll = nowMs - channel.lastPollMs;
+  return channel.alertEdges.pending() || (channel.polled() && sincePoll >= channel.config->pollMs) ||
+         (channel.alerts.active() != 0 && sincePoll >= LIMIT_POLL_MS);
+}
+
+// One channel per run, round-robin from the one after the last served, so a
+// busy channel can't starve the others and a run costs one sensor's reads
+// however many channels there are. The task runs again while more are due.
+void processInaAlerts()
+{
+  const uint32_t nowMs = millis();
+  for (size_t i = 0; i < INA_CHANNEL_COUNT; ++i)
+  {
+    const size_t index = (nextChannel + i) % INA_CHANNEL_COUNT;
+    if (channelDue(channels[index], nowMs))
+    {
+      nextChannel = (index + 1) % INA_CHANNEL_COUNT;
+      processChannel(index);
+      return;
+    }
+  }
+}
 
-    // formatValue expects base unit in base units (A), so convert mA -> A
-    const String stdDevStr = formatValue(stdDev_mA / 1000.0f, "A", 5);
-    const String rangeStr  = formatValue(fluctuation_mA / 1000.0f, "A", 5);
+// the burst dump is fed in as the queue frees up, so it never drops records
+void queueBurstSamples()
+{
+  while (burstDumpIndex < burstCapture.count() && logger.freeRecords() > 1)
+  {
+    BurstSampleLog record;
+    record.captureId = burstCapture.captureId();
+    record.index     = burstDumpIndex;
+    record.offsetUs  = burstCapture.offsetUs(burstDumpIndex);
+    record.current   = burstCapture.current(burstDumpIndex);
+    logger.logBurstSample(record);
+    ++burstDumpIndex;
+  }
+}
 
-    Serial.printf("[meas %lu] Vbus=%s Vshunt=%s Temp=%.2f C I=%s E=%s | I-stddev=%s (%.3f%%) I-range=%s (%.3f%%)\n",
-                  static_cast<unsigned long>(historyCount),
-                  formatValue(lastMeasuredValues.vBus,   "V", 5).c_str(),
-                  formatValue(lastMeasuredValues.vShunt, "V", 5).c_str(),
-                  lastMeasuredValues.temperature,
-                  formatValue(lastMeasuredValues.current_mA / 1000.0f, "A",  5).c_str(),
-                  formatValue(lastMeasuredValues.energyWs   / 3600.0f, "Wh", 5).c_str(),
-                  stdDevStr.c_str(),
-                  stdDevPercent,
-                  rangeStr.c_str(),
-                  rangePercent);
+// only runs when the UART can take bytes without blocking
+bool logReady()
+{
+  const bool pending = (SERIAL_OUTPUT == SerialOutput::Binary) ? telemetryStream.pending() : logger.pending();
+  return pending && Serial.availableForWrite() > 0;
+}
 
-    // Output in plotter-friendly format (CSV)
-    Serial.printf(">I_avg:%.2f\n", mean_mA);
-    Serial.printf(">I_stddev:%.4f\n", stdDev_mA);
+void drainLog()
+{
+  ProfileScope scope(&profiler, ProfileStage::SerialLog);
+  if (SERIAL_OUTPUT == SerialOutput::Binary)
+  {
+    telemetryStream.drain(Serial);
   }
   else
   {
-    Serial.printf("[meas %lu] Vbus=%s Vshunt=%s Temp=%.2f C I=%s E=%s (insufficient history for fluctuation)\n",
-                  static_cast<unsigned long>(historyCount),
-                  formatValue(lastMeasuredValues.vBus,   "V", 5).c_str(),
-                  formatValue(lastMeasuredValues.vShunt, "V", 5).c_str(),
-                  lastMeasuredValues.temperature,
-                  formatValue(lastMeasuredValues.current_mA / 1000.0f, "A", 5).c_str(),
-                  formatValue(lastMeasuredValues.energyWs / 3600.0f, "Wh", 5).c_str());
+    logger.drain(Serial);
+    queueBurstSamples();
   }
+}
+
+// Blocks for the whole capture (about 0.3 s); samples are not acquired meanwhile.
+// Runs on the first channel.
+void captureBurst()
+{
+  InaChannel &channel = channels[0];
+  if (!burstCapture.run(channel.reader))
+  {
+    logger.logMessage(LogLevel::Error, F("Burst capture failed"));
+  }
+
+  // every conversion of the burst raised ALERT; the regular profile restarts now
+  channel.alertEdges.discard();
+  channel.timing.restart();
+
+  BurstLog record;
+  record.captureId  = burstCapture.captureId();
+  record.count      = burstCapture.count();
+  record.durationUs = burstCapture.durationUs();
+  record.minCurrent = burstCapture.minCurrent();
+  record.maxCurrent = burstCapture.maxCurrent();
+  logger.logBurst(record);
+
+  burstDumpIndex = (SERIAL_OUTPUT == SerialOutput::Text && logger.enabled(LogLevel::Debug)) ? 0 : BurstCapture::kCapacity;
+  queueBurstSamples();
+
+  displayMode    = DisplayMode::Burst;
+  displayPending = true;
+}
+
+bool acquireReady()
+{
+  const uint32_t nowMs = millis();
+  for (const InaChannel &channel : channels)
+  {
+    if (channelDue(channel, nowMs))
+      return true;
+  }
+  return false;
+}
+
+bool energyLogReady()
+{
+  return energyLog.writeDue(millis());
+}
+
+void writeEnergyLog()
+{
+  energyLog.writePage(millis());
+}
+
+bool burstReady()
+{
+  return channels[0].ready && burstCapture.requested();
+}
+
+// the framebuffer is left alone while the last frame is still being sent
+bool displayReady()
+{
+  return displayPending && !displayManager.busy();
+}
+
+void refreshDisplay()
+{
+  displayPending = false;
 
-  webInterface.updateMeasurements(lastMeasuredValues);
-  displayManager.showMeasurements(lastMeasuredValues, lastEnergyDeltaWs, lastMeasurementOk, webConnected, webIp, measurementHistory, displayMode);
+  // no label while there is only the one channel
+  const bool           total    = (displayChannel == INA_CHANNEL_COUNT);
+  const MeterReadings &readings = total ? totalReadings : channels[displayChannel].readings;
+  const char          *label    = (INA_CHANNEL_COUNT == 1) ? nullptr : total ? "Total" : INA_CHANNELS[displayChannel].name;
+  displayManager.showMeasurements(readings, label, webConnected, webIp, tieredHistory, displayMode, graphRange);
+}
+
+bool i2cReady()
+{
+  return i2cTransfers.pending();
+}
+
+void runI2cStep()
+{
+  i2cTransfers.runStep();
+}
+
+void serviceWeb()
+{
+  ProfileScope scope(&profiler, ProfileStage::Web);
+  webInterface.loop();
+  webConnected = webInterface.isConnected();
+  webIp        = webInterface.localIp();
+}
+
+void reportTaskStats()
+{
+  for (uint8_t i = 0; i < scheduler.taskCount(); ++i)
+  {
+    const Scheduler::TaskStats &stats = scheduler.stats(i);
+    const uint32_t              avgUs = (stats.runs > 0) ? static_cast<uint32_t>(stats.totalUs / stats.runs) : 0;
+
+    TaskLog record;
+    record.name      = scheduler.config(i).name;
+    record.runs      = stats.runs;
+    record.avgUs     = avgUs;
+    record.maxUs     = stats.maxUs;
+    record.latencyUs = stats.maxLatencyUs;
+    record.overruns  = stats.overruns;
+    record.late      = stats.deadlineMisses;
+    logger.logTask(record);
+  }
+}
 
-  // Reading alert flags clears the CONV_READY alert so it can fire again.
-  ina228.alertFunctionFlags();
+// Acquisition outranks everything else: an alert is serviced after at most
+// one running task, whose worst case shows up in the task report. Display
+// frames go out a page per "i2c" run, so a flush delays it by one page.
+void setupTasks()
+{
+  using Priority = Scheduler::Priority;
+
+  static const Scheduler::TaskConfig tasks[] = {
+      // name, run, ready, priority, period [ms], budget [us], deadline [us]
+      { "acquire", processInaAlerts, acquireReady,                     Priority::High,   0,                    2000,  50000 },
+      { "button",  handleButton,     nullptr,                          Priority::Normal, BUTTON_POLL_MS,       200,   0     },
+      { "burst",   captureBurst,     burstReady,                       Priority::Normal, 0,                    0,     0     },
+      { "display", refreshDisplay,   displayReady,                     Priority::Normal, 0,                    50000, 0     },
+      { "i2c",     runI2cStep,       i2cReady,                         Priority::Normal, 0,                    5000,  0     },
+      { "web",     serviceWeb,       nullptr,                          Priority::Normal, WEB_LOOP_INTERVAL_MS, 20000, 0     },
+      { "log",     drainLog,         logReady,                         Priority::Low,    0,                    2000,  0     },
+      { "flash",   writeEnergyLog,   energyLogReady,                   Priority::Low,    0,                    50000, 0     },
+      { "report",  reportTaskStats,  nullptr,                          Priority::Low,    TASK_REPORT_MS,       0,     0     },
+  };
+
+  for (const Scheduler::TaskConfig &task : tasks)
+  {
+    scheduler.addTask(task);
+  }
 }
 
 void setup()
 {
   Serial.begin(115200);
+  logger.setLevel(LOG_LEVEL);
   delay(50);
 
-  pinMode(BUTTON_PIN,    INPUT_PULLUP);
-  pinMode(INA_ALERT_PIN, INPUT_PULLUP);
+  pinMode(BUTTON_PIN, INPUT_PULLUP);
 
   Wire.begin(SDA_PIN, SCL_PIN);
   Wire.setClock(400000);
 
-  if (!ina228.begin(INA228_ADDR, &Wire))
+  for (size_t i = 0; i < INA_CHANNEL_COUNT; ++i)
   {
-    Serial.println(F("INA228 could not be initialized."));
-  }
-  else
-  {
-    ina228.setADCRange(1);
-    ina228.setAveragingCount(INA228_COUNT_256);
-    ina228.setCurrentConversionTime(INA228_TIME_4120_us);
-    ina228.setVoltageConversionTime(INA228_TIME_4120_us);
-    ina228.setTemperatureConversionTime(INA228_TIME_1052_us);
-    ina228.setMode(INA228_MODE_CONTINUOUS);
-    ina228.setAlertPolarity(INA228_ALERT_POLARITY_INVERTED);
-    ina228.setAlertLatch(INA228_ALERT_LATCH_TRANSPARENT);
-    ina228.setAlertType(INA228_ALERT_CONVERSION_READY);
-    ina228.setShunt(INA228_SHUNT_OHMS);
-    ina228.resetAccumulators();
-    Serial.println(F("INA228 init OK"));
-    inaReady = true;
+    InaChannel &channel = channels[i];
+    const bool  ok      = channel.begin(INA_CHANNELS[i], ina228, Wire);
+    Serial.print(F("INA228 "));
+    Serial.print(INA_CHANNELS[i].name);
+    Serial.println(ok ? F(" init OK") : F(" could not be initialized."));
 
-    attachInterrupt(digitalPinToInterrupt(INA_ALERT_PIN), onInaAlert, FALLING);
+    if (ok && !channel.polled())
+    {
+      pinMode(channel.config->alertPin, INPUT_PULLUP);
+      attachInterruptArg(digitalPinToInterrupt(channel.config->alertPin), onInaAlert, &channel, FALLING);
+    }
   }
 
   displayManager.begin();
+  displayManager.attachBurst(&burstCapture);
+  displayManager.attachChannels(channels, INA_CHANNEL_COUNT);
+  displayManager.attachTrigger(&triggerCapture);
+  displayManager.attachProfiler(&profiler);
+  displayManager.attachBus(&i2cTransfers);
   displayManager.showConnecting(secrets::WIFI_SSID);
 
+  // restores the history before the first live sample
+  if (energyLog.begin(tieredHistory))
+  {
+    meterTimeBase = energyLog.resumeSeconds();
+    loggedBuckets = tieredHistory.closedCount(HistoryTier::Hour);
+    Serial.print(F("Energy log: "));
+    Serial.print(energyLog.restoredRecords());
+    Serial.println(F(" records restored"));
+  }
+  else
+  {
+    Serial.println(F("Energy log: LittleFS mount failed"));
+  }
+
+  webInterface.attachHistory(&tieredHistory);
+  webInterface.attachEnergyLog(&energyLog);
+  webInterface.attachSamples(&totalReadings.history);
+  webInterface.attachArchive(&sampleArchive);
+  webInterface.attachBurst(&burstCapture);
+  webInterface.attachChannels(channels, INA_CHANNEL_COUNT);
+  webInterface.attachTrigger(&triggerCapture);
+  webInterface.attachProfiler(&profiler);
+  webInterface.attachScheduler(&scheduler);
   webConnected = webInterface.begin(secrets::WIFI_SSID, secrets::WIFI_PASSWORD);
   webIp        = webInterface.localIp();
 
-  lastMeasurementOk = readInaValues(lastMeasuredValues);
+  for (InaChannel &channel : channels)
+  {
+    channel.readings.ok = channel.ready && channel.reader.read(channel.readings.values);
+    totalReadings.ok    = totalReadings.ok || channel.readings.ok;
+  }
+  totalReadings.values = sumChannels(channels, INA_CHANNEL_COUNT);
+
+  TriggerCapture::Config trigger;
+  trigger.level       = TriggerCapture::levelCode(TriggerCapture::Source::Current, TRIGGER_LEVEL_A);
+  trigger.preSamples  = TRIGGER_PRE_SAMPLES;
+  trigger.postSamples = TRIGGER_POST_SAMPLES;
+  triggerCapture.arm(trigger);
+
+  setupTasks();
 }
 
 
 void loop()
 {
-  handleButton();
-  processInaAlerts();
-
-  static unsigned long lastWebLoop = 0;
-  const unsigned long  now         = millis();
-
-  if (now - lastWebLoop >= WEB_LOOP_INTERVAL_MS)
-  {
-    webInterface.loop();
-    webConnected = webInterface.isConnected();
-    webIp        = webInterface.localIp();
-
-    lastWebLoop = now;
-  }
+  profiler.markLoop();
+  scheduler.runNext();
 }
@@ -0,0 +1,53 @@
+#include "profiler.h"
+
+Profiler::Profiler()
+    : m_histograms()
+    , m_lastLoopCycles(0)
+    , m_maxLoopGapUs(0)
+    , m_hasLoop(false)
+{
+}
+
+void Profiler::record(ProfileStage stage, uint32_t cycles)
+{
+  m_histograms[static_cast<size_t>(stage)].add(cycles / ESP.getCpuFreqMHz());
+}
+
+void Profiler::markLoop()
+{
+  const uint32_t now = ESP.getCycleCount();
+  if (m_hasLoop)
+  {
+    const uint32_t gapUs = (now - m_lastLoopCycles) / ESP.getCpuFreqMHz();
+    if (gapUs > m_maxLoopGapUs)
+      m_maxLoopGapUs = gapUs;
+  }
+  m_lastLoopCycles = now;
+  m_hasLoop        = true;
+}
+
+const char *Profiler::stageName(ProfileStage stage)
+{
+  switch (stage)
+  {
+    case ProfileStage::InaRead:       return "ina_read";
+    case ProfileStage::History:       return "history";
+    case ProfileStage::Stats:         return "stats";
+    case ProfileStage::SerialLog:     return "serial_log";
+    case ProfileStage::DisplayRender: return "display_render";
+    case ProfileStage::DisplayFlush:  return "display_flush";
+    case ProfileStage::Web:           return "web";
+    case ProfileStage::WebRequest:    return "web_request";
+    default:                          return "?";
+  }
+}
+
+const LatencyHistogram &Profiler::histogram(ProfileStage stage) const
+{
+  return m_histograms[static_cast<size_t>(stage)];
+}
+
+uint32_t Profiler::maxLoopGapUs() const
+{
+  return m_maxLoopGapUs;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "latency_histogram.h"
+
+// Stages of the main loop that are timed with the CPU cycle counter.
+enum class ProfileStage : uint8_t
+{
+  InaRead,       // one INA228 read: DIAG_ALRT or the measurement registers
+  History,       // sample history, tiers and energy log queue
+  Stats,         // window statistics for the log line
+  SerialLog,     // formatting and UART output
+  DisplayRender, // drawing into the framebuffer
+  DisplayFlush,  // I2C transfer of the changed runs, one page when queued
+  Web,           // WebInterface::loop()
+  WebRequest,    // one HTTP request handler
+  Count
+};
+
+// Latency histograms per stage plus the longest main loop gap, served by
+// WebInterface as /metrics. Recording costs two cycle counter reads and a
+// short bucket scan, no allocation.
+class Profiler
+{
+public:
+  static constexpr size_t kStageCount = static_cast<size_t>(ProfileStage::Count);
+
+  Profiler();
+
+  void record(ProfileStage stage, uint32_t cycles);
+
+  // Called once per loop() iteration. The cycle counter wraps after 26 s at
+  // 160 MHz, longer gaps are misreported.
+  void markLoop();
+
+  static const char *stageName(ProfileStage stage);
+
+  const LatencyHistogram &histogram(ProfileStage stage) const;
+  uint32_t                maxLoopGapUs() const;
+
+private:
+  LatencyHistogram m_histograms[kStageCount];
+  uint32_t         m_lastLoopCycles;
+  uint32_t         m_maxLoopGapUs;
+  bool             m_hasLoop;
+};
+
+// Times the enclosing block; finish() ends the measurement early. A null
+// profiler makes it a no-op, so modules can be used without one attached.
+class ProfileScope
+{
+public:
+  ProfileScope(Profiler *profiler, ProfileStage stage)
+      : m_profiler(profiler)
+      , m_stage(stage)
+      , m_startCycles(ESP.getCycleCount())
+  {
+  }
+
+  ~ProfileScope()
+  {
+    finish();
+  }
+
+  void finish()
+  {
+    if (m_profiler != nullptr)
+    {
+      m_profiler->record(m_stage, ESP.getCycleCount() - m_startCycles);
+      m_profiler = nullptr;
+    }
+  }
+
+private:
+  Profiler    *m_profiler;
+  ProfileStage m_stage;
+  uint32_t     m_startCycles;
+};
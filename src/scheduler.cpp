@@ -0,0 +1,112 @@
+#include "scheduler.h"
+
+Scheduler::Scheduler()
+    : m_tasks()
+    , m_count(0)
+{
+}
+
+uint8_t Scheduler::addTask(const TaskConfig &config)
+{
+  if (m_count >= kMaxTasks || config.run == nullptr)
+  {
+    return kInvalidTask;
+  }
+
+  Task &task      = m_tasks[m_count];
+  task.config     = config;
+  task.stats      = TaskStats();
+  task.nextDueMs  = millis() + config.periodMs;
+  task.releasedUs = 0;
+  task.released   = false;
+  return m_count++;
+}
+
+bool Scheduler::isDue(const Task &task, uint32_t nowMs) const
+{
+  if (task.config.periodMs != 0 && static_cast<int32_t>(nowMs - task.nextDueMs) >= 0)
+  {
+    return true;
+  }
+  return task.config.ready != nullptr && task.config.ready();
+}
+
+bool Scheduler::runNext()
+{
+  const uint32_t nowMs = millis();
+  const uint32_t nowUs = micros();
+
+  // the release time is when a task was first seen due; runNext() is called
+  // back to back, so that is at most one task execution late
+  Task *next = nullptr;
+  for (uint8_t i = 0; i < m_count; ++i)
+  {
+    Task &task = m_tasks[i];
+    if (!task.released)
+    {
+      if (!isDue(task, nowMs))
+      {
+        continue;
+      }
+      task.released   = true;
+      task.releasedUs = nowUs;
+    }
+
+    if (next == nullptr || task.config.priority < next->config.priority ||
+        (task.config.priority == next->config.priority && static_cast<int32_t>(task.releasedUs - next->releasedUs) < 0))
+    {
+      next = &task;
+    }
+  }
+
+  if (next == nullptr)
+  {
+    return false;
+  }
+
+  const uint32_t startUs = micros();
+  next->config.run();
+  const uint32_t elapsedUs = micros() - startUs;
+  const uint32_t latencyUs = startUs - next->releasedUs;
+
+  TaskStats &stats = next->stats;
+  ++stats.runs;
+  stats.lastUs   = elapsedUs;
+  stats.totalUs += elapsedUs;
+  if (elapsedUs > stats.maxUs)
+    stats.maxUs = elapsedUs;
+  if (latencyUs > stats.maxLatencyUs)
+    stats.maxLatencyUs = latencyUs;
+  if (next->config.budgetUs != 0 && elapsedUs > next->config.budgetUs)
+    ++stats.overruns;
+  if (next->config.deadlineUs != 0 && latencyUs > next->config.deadlineUs)
+    ++stats.deadlineMisses;
+
+  next->released = false;
+  if (next->config.periodMs != 0)
+  {
+    // keep the period grid, but skip periods that were missed entirely
+    next->nextDueMs += next->config.periodMs;
+    const uint32_t afterMs = millis();
+    if (static_cast<int32_t>(afterMs - next->nextDueMs) >= 0)
+    {
+      next->nextDueMs = afterMs + next->config.periodMs;
+    }
+  }
+  return true;
+}
+
+uint8_t Scheduler::taskCount() const
+{
+  return m_count;
+}
+
+const Scheduler::TaskConfig &Scheduler::config(uint8_t task) const
+{
+  return m_tasks[task].config;
+}
+
+const Scheduler::TaskStats &Scheduler::stats(uint8_t task) const
+{
+  return m_tasks[task].stats;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Cooperative run-to-completion scheduler. Every runNext() starts at most one
+// task, the highest-priority one that is due, so a task waits for at most one
+// lower-priority execution once it becomes due. Tasks must not block.
+//
+// Execution time and start latency are measured per task and compared with
+// the configured budget and deadline.
+class Scheduler
+{
+public:
+  static constexpr uint8_t kMaxTasks    = 10;
+  static constexpr uint8_t kInvalidTask = 0xFF;
+
+  enum class Priority : uint8_t
+  {
+    High,
+    Normal,
+    Low
+  };
+
+  using TaskFunction  = void (*)();
+  using ReadyFunction = bool (*)();
+
+  struct TaskConfig
+  {
+    const char   *name;
+    TaskFunction  run;
+    ReadyFunction ready;      // event trigger, may be nullptr
+    Priority      priority;
+    uint32_t      periodMs;   // 0: only runs when ready() returns true
+    uint32_t      budgetUs;   // execution time budget, 0: none
+    uint32_t      deadlineUs; // allowed start latency once due, 0: none
+  };
+
+  struct TaskStats
+  {
+    uint32_t runs;
+    uint32_t overruns;       // executions longer than budgetUs
+    uint32_t deadlineMisses; // starts later than deadlineUs
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint32_t maxLatencyUs;   // due -> started
+  };
+
+  Scheduler();
+
+  uint8_t addTask(const TaskConfig &config);
+
+  // Runs the most urgent due task; returns false if nothing was due.
+  bool runNext();
+
+  uint8_t           taskCount() const;
+  const TaskConfig &config(uint8_t task) const;
+  const TaskStats  &stats(uint8_t task) const;
+
+private:
+  struct Task
+  {
+    TaskConfig config;
+    TaskStats  stats;
+    uint32_t   nextDueMs;
+    uint32_t   releasedUs;
+    bool       released;
+  };
+
+  bool isDue(const Task &task, uint32_t nowMs) const;
+
+  Task    m_tasks[kMaxTasks];
+  uint8_t m_count;
+};
@@ -0,0 +1,396 @@
+#include "serial_logger.h"
+
+#include <string.h>
+
+#include "ina_values.h"
+#include "value_format.h"
+
+namespace
+{
+  // Appends to a fixed buffer, truncating at the end.
+  class LineWriter
+  {
+  public:
+    LineWriter(char *buffer, size_t size)
+        : m_buffer(buffer)
+        , m_size(size)
+        , m_length(0)
+    {
+      m_buffer[0] = '\0';
+    }
+
+    void append(const char *text)
+    {
+      while (*text != '\0' && m_length + 1 < m_size)
+      {
+        m_buffer[m_length++] = *text++;
+      }
+      m_buffer[m_length] = '\0';
+    }
+
+    void append(const __FlashStringHelper *text)
+    {
+      PGM_P p = reinterpret_cast<PGM_P>(text);
+      for (char c = pgm_read_byte(p); c != '\0' && m_length + 1 < m_size; c = pgm_read_byte(++p))
+      {
+        m_buffer[m_length++] = c;
+      }
+      m_buffer[m_length] = '\0';
+    }
+
+    // left-aligned in `width` columns, like "%-7s"
+    void appendPadded(const char *text, size_t width)
+    {
+      const size_t start = m_length;
+      append(text);
+      while (m_length - start < width && m_length + 1 < m_size)
+      {
+        m_buffer[m_length++] = ' ';
+      }
+      m_buffer[m_length] = '\0';
+    }
+
+    void appendUnsigned(uint32_t value)
+    {
+      char    digits[11];
+      uint8_t count = sizeof(digits) - 1;
+      digits[count] = '\0';
+      do
+      {
+        digits[--count] = static_cast<char>('0' + value % 10);
+        value /= 10;
+      } while (value != 0);
+      append(&digits[count]);
+    }
+
+    void appendDecimal(float value, uint8_t decimals)
+    {
+      m_length += formatDecimal(m_buffer + m_length, m_size - m_length, value, decimals);
+    }
+
+    template <typename Scale>
+    void appendScaled(int64_t raw, const char *unit, uint8_t digits)
+    {
+      m_length += formatScaled<Scale>(m_buffer + m_length, m_size - m_length, raw, unit, digits);
+    }
+
+    void appendValue(float value, const char *unit, uint8_t digits)
+    {
+      m_length += formatValue(m_buffer + m_length, m_size - m_length, value, unit, digits);
+    }
+
+    size_t length() const
+    {
+      return m_length;
+    }
+
+  private:
+    char  *m_buffer;
+    size_t m_size;
+    size_t m_length;
+  };
+}
+
+SerialLogger::SerialLogger()
+    : m_records()
+    , m_head(0)
+    , m_count(0)
+    , m_level(LogLevel::Debug)
+    , m_dropped(0)
+    , m_reportedDropped(0)
+    , m_lineLength(0)
+    , m_linePos(0)
+{
+  m_line[0] = '\0';
+}
+
+void SerialLogger::setLevel(LogLevel level)
+{
+  m_level = level;
+}
+
+LogLevel SerialLogger::level() const
+{
+  return m_level;
+}
+
+bool SerialLogger::enabled(LogLevel level) const
+{
+  return level <= m_level;
+}
+
+SerialLogger::Record *SerialLogger::push(RecordType type, LogLevel level)
+{
+  if (!enabled(level))
+  {
+    return nullptr;
+  }
+
+  if (m_count == kCapacity)
+  {
+    ++m_dropped;
+    return nullptr;
+  }
+
+  Record &record = m_records[(m_head + m_count) % kCapacity];
+  ++m_count;
+  record.type  = type;
+  record.level = level;
+  return &record;
+}
+
+void SerialLogger::logMessage(LogLevel level, const __FlashStringHelper *text)
+{
+  Record *record = push(RecordType::Message, level);
+  if (record != nullptr)
+  {
+    record->message = text;
+  }
+}
+
+void SerialLogger::logMeasurement(const MeasurementLog &measurement)
+{
+  Record *record = push(RecordType::Measurement, LogLevel::Info);
+  if (record != nullptr)
+  {
+    record->measurement = measurement;
+  }
+}
+
+void SerialLogger::logTask(const TaskLog &task)
+{
+  Record *record = push(RecordType::Task, LogLevel::Info);
+  if (record != nullptr)
+  {
+    record->task = task;
+  }
+}
+
+void SerialLogger::logBurst(const BurstLog &burst)
+{
+  Record *record = push(RecordType::Burst, LogLevel::Info);
+  if (record != nullptr)
+  {
+    record->burst = burst;
+  }
+}
+
+void SerialLogger::logBurstSample(const BurstSampleLog &sample)
+{
+  Record *record = push(RecordType::BurstSample, LogLevel::Debug);
+  if (record != nullptr)
+  {
+    record->burstSample = sample;
+  }
+}
+
+void SerialLogger::logAlert(const AlertLog &alert)
+{
+  Record *record = push(RecordType::Alert, LogLevel::Error);
+  if (record != nullptr)
+  {
+    record->alert = alert;
+  }
+}
+
+size_t SerialLogger::freeRecords() const
+{
+  return kCapacity - m_count;
+}
+
+bool SerialLogger::pending() const
+{
+  return m_count > 0 || m_linePos < m_lineLength || m_dropped != m_reportedDropped;
+}
+
+uint32_t SerialLogger::dropped() const
+{
+  return m_dropped;
+}
+
+void SerialLogger::drain(Print &out)
+{
+  while (m_linePos < m_lineLength || formatNext())
+  {
+    const int room = out.availableForWrite();
+    if (room <= 0)
+    {
+      return;
+    }
+
+    const size_t remaining = m_lineLength - m_linePos;
+    const size_t chunk     = (static_cast<size_t>(room) < remaining) ? static_cast<size_t>(room) : remaining;
+    out.write(reinterpret_cast<const uint8_t *>(m_line + m_linePos), chunk);
+    m_linePos += chunk;
+  }
+}
+
+bool SerialLogger::formatNext()
+{
+  m_linePos    = 0;
+  m_lineLength = 0;
+
+  if (m_dropped != m_reportedDropped)
+  {
+    LineWriter line(m_line, sizeof(m_line));
+    line.append("[log] dropped ");
+    line.appendUnsigned(m_dropped - m_reportedDropped);
+    line.append(" records\n");
+    m_lineLength      = line.length();
+    m_reportedDropped = m_dropped;
+    return true;
+  }
+
+  if (m_count == 0)
+  {
+    return false;
+  }
+
+  formatRecord(m_records[m_head]);
+  m_head = (m_head + 1) % kCapacity;
+  --m_count;
+  return true;
+}
+
+void SerialLogger::formatRecord(const Record &record)
+{
+  LineWriter line(m_line, sizeof(m_line));
+
+  switch (record.type)
+  {
+    case RecordType::Message:
+      line.append(record.message);
+      line.append("\n");
+      break;
+
+    case RecordType::Measurement:
+    {
+      const MeasurementLog &m = record.measurement;
+      line.append("[meas ");
+      line.appendUnsigned(m.count);
+      line.append("] Vbus=");
+      line.appendScaled<ina::BusVoltageScale>(m.vBus, "V", 5);
+      line.append(" Vshunt=");
+      line.appendScaled<ina::ShuntVoltageScale>(m.vShunt, "V", 5);
+      line.append(" Temp=");
+      line.appendDecimal(ina::DieTempScale::toFloat(m.dieTemp), 2);
+      line.append(" C I=");
+      line.appendScaled<ina::CurrentScale>(m.current, "A", 5);
+      line.append(" E=");
+      line.appendScaled<ina::EnergyWhScale>(static_cast<int64_t>(m.energy), "Wh", 5);
+
+      if (!m.hasStats)
+      {
+        line.append(" (insufficient history for fluctuation)\n");
+        break;
+      }
+
+      // ratios are unit-free, so they are taken directly on LSB counts
+      const float stdDevPercent = (m.mean > 0.0f) ? (m.stdDeviation / m.mean) * 100.0f : 0.0f;
+      const float rangePercent  = (m.mean > 0.0f) ? (m.range / m.mean) * 100.0f : 0.0f;
+      const float stdDev_A      = m.stdDeviation * ina::CurrentScale::kFactor;
+
+      line.append(" | I-stddev=");
+      line.appendValue(stdDev_A, "A", 5);
+      line.append(" (");
+      line.appendDecimal(stdDevPercent, 3);
+      line.append("%) I-range=");
+      line.appendScaled<ina::CurrentScale>(m.range, "A", 5);
+      line.append(" (");
+      line.appendDecimal(rangePercent, 3);
+      line.append("%)\n");
+
+      if (enabled(LogLevel::Debug))
+      {
+        // Output in plotter-friendly format (CSV), in mA
+        line.append(">I_avg:");
+        line.appendDecimal(m.mean * ina::CurrentScale::kFactor * 1000.0f, 2);
+        line.append("\n>I_stddev:");
+        line.appendDecimal(stdDev_A * 1000.0f, 4);
+        line.append("\n");
+      }
+      break;
+    }
+
+    case RecordType::Task:
+    {
+      const TaskLog &t = record.task;
+      line.append("[task ");
+      line.appendPadded(t.name, 7);
+      line.append("] runs=");
+      line.appendUnsigned(t.runs);
+      line.append(" avg=");
+      line.appendUnsigned(t.avgUs);
+      line.append("us max=");
+      line.appendUnsigned(t.maxUs);
+      line.append("us latency=");
+      line.appendUnsigned(t.latencyUs);
+      line.append("us overruns=");
+      line.appendUnsigned(t.overruns);
+      line.append(" late=");
+      line.appendUnsigned(t.late);
+      line.append("\n");
+      break;
+    }
+
+    case RecordType::Burst:
+    {
+      const BurstLog &b = record.burst;
+      line.append("[burst ");
+      line.appendUnsigned(b.captureId);
+      line.append("] ");
+      line.appendUnsigned(b.count);
+      line.append(" samples in ");
+      line.appendValue(b.durationUs * 1e-6f, "s", 4);
+      line.append(" I-min=");
+      line.appendScaled<ina::CurrentScale>(b.minCurrent, "A", 5);
+      line.append(" I-max=");
+      line.appendScaled<ina::CurrentScale>(b.maxCurrent, "A", 5);
+      line.append("\n");
+      break;
+    }
+
+    case RecordType::BurstSample:
+    {
+      const BurstSampleLog &b = record.burstSample;
+      line.append("burst,");
+      line.appendUnsigned(b.captureId);
+      line.append(",");
+      line.appendUnsigned(b.index);
+      line.append(",");
+      line.appendUnsigned(b.offsetUs);
+      line.append(",");
+      line.appendDecimal(b.current * ina::CurrentScale::kFactor * 1e6f, 2);
+      line.append("\n");
+      break;
+    }
+
+    case RecordType::Alert:
+    {
+      const AlertEvent &e = record.alert.event;
+      line.append("[alert ");
+      line.appendUnsigned(record.alert.number);
+      line.append("] t=");
+      line.appendUnsigned(e.timestampUs);
+      line.append("us");
+      if (e.flags == 0)
+      {
+        line.append(" transient");
+      }
+      forEachAlertFlag(e.flags,
+                       [&](const char *name)
+                       {
+                         line.append(" ");
+                         line.append(name);
+                       });
+      line.append(" I=");
+      line.appendScaled<ina::CurrentScale>(e.current, "A", 5);
+      line.append(" Vbus=");
+      line.appendScaled<ina::BusVoltageScale>(e.vBus, "V", 4);
+      line.append("\n");
+      break;
+    }
+  }
+
+  m_lineLength = line.length();
+}
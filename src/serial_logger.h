@@ -0,0 +1,134 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "alert_events.h"
+
+enum class LogLevel : uint8_t
+{
+  Error,
+  Info,
+  Debug // includes the >I_avg/>I_stddev plotter lines
+};
+
+// One conversion as logged: raw register codes plus the window statistics in
+// CURRENT LSB counts (see MeasurementHistory::CurrentStats).
+struct MeasurementLog
+{
+  uint32_t count;    // samples in the statistics window
+  int32_t  vBus;
+  int32_t  vShunt;
+  int32_t  current;
+  uint64_t energy;
+  int16_t  dieTemp;
+  bool     hasStats; // false with fewer than two samples
+  int32_t  range;    // max - min
+  float    mean;
+  float    stdDeviation;
+};
+
+struct TaskLog
+{
+  const char *name;
+  uint32_t    runs;
+  uint32_t    avgUs;
+  uint32_t    maxUs;
+  uint32_t    latencyUs;
+  uint32_t    overruns;
+  uint32_t    late;
+};
+
+struct BurstLog
+{
+  uint32_t captureId;
+  uint32_t count;
+  uint32_t durationUs;
+  int32_t  minCurrent; // CURRENT LSB
+  int32_t  maxCurrent;
+};
+
+// One line of the burst dump: "burst,<capture>,<index>,<offset us>,<current uA>"
+struct BurstSampleLog
+{
+  uint32_t captureId;
+  uint32_t index;
+  uint32_t offsetUs;
+  int32_t  current;
+};
+
+struct AlertLog
+{
+  uint32_t   number; // counts from 1 at boot
+  AlertEvent event;
+};
+
+// Logging that never blocks the caller: log*() only copies a small binary
+// record into a RAM ring (dropping it if the ring is full), drain() formats
+// the records and writes only as many bytes as the UART TX FIFO can take.
+class SerialLogger
+{
+public:
+  static constexpr size_t kCapacity = 16;
+
+  SerialLogger();
+
+  void     setLevel(LogLevel level);
+  LogLevel level() const;
+  bool     enabled(LogLevel level) const;
+
+  void logMessage(LogLevel level, const __FlashStringHelper *text);
+  void logMeasurement(const MeasurementLog &measurement);
+  void logTask(const TaskLog &task);
+  void logBurst(const BurstLog &burst);
+  void logBurstSample(const BurstSampleLog &sample); // Debug level
+  void logAlert(const AlertLog &alert);              // Error level
+
+  size_t freeRecords() const;
+
+  // Something is queued or a line is partially sent.
+  bool pending() const;
+
+  void drain(Print &out);
+
+  uint32_t dropped() const;
+
+private:
+  enum class RecordType : uint8_t
+  {
+    Message,
+    Measurement,
+    Task,
+    Burst,
+    BurstSample,
+    Alert
+  };
+
+  struct Record
+  {
+    RecordType type;
+    LogLevel   level;
+    union
+    {
+      const __FlashStringHelper *message;
+      MeasurementLog             measurement;
+      TaskLog                    task;
+      BurstLog                   burst;
+      BurstSampleLog             burstSample;
+      AlertLog                   alert;
+    };
+  };
+
+  Record *push(RecordType type, LogLevel level);
+  bool    formatNext();
+  void    formatRecord(const Record &record);
+
+  Record   m_records[kCapacity];
+  size_t   m_head;
+  size_t   m_count;
+  LogLevel m_level;
+  uint32_t m_dropped;
+  uint32_t m_reportedDropped;
+  char     m_line[256];
+  size_t   m_lineLength;
+  size_t   m_linePos;
+};
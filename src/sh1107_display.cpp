@@ -0,0 +1,106 @@
+#include "sh1107_display.h"
+
+#include "frame_diff.h"
+
+namespace
+{
+  // A new run costs a command transaction plus a data header, so gaps of up to
+  // this many unchanged columns are sent along instead of splitting the run.
+  constexpr uint8_t MERGE_GAP = 8;
+
+  constexpr uint8_t DATA_PREFIX = 0x40;
+}
+
+Sh1107Display::Sh1107Display(uint16_t width, uint16_t height, TwoWire *wire, int8_t resetPin)
+    : Adafruit_SH1107(width, height, wire, resetPin)
+    , m_shadowValid(false)
+    , m_flushPage(0)
+    , m_flushBytes(0)
+    , m_lastFlushBytes(0)
+{
+}
+
+bool Sh1107Display::begin(uint8_t address, bool reset)
+{
+  m_shadowValid = false;
+
+  if (WIDTH > kMaxWidth || HEIGHT > kMaxHeight)
+  {
+    return false;
+  }
+
+  return Adafruit_SH1107::begin(address, reset);
+}
+
+void Sh1107Display::display()
+{
+  // ESP8266 needs a periodic yield() call to avoid watchdog reset.
+  yield();
+
+  startFlush();
+  while (!flushNextPage())
+  {
+  }
+}
+
+void Sh1107Display::startFlush()
+{
+  m_flushPage  = 0;
+  m_flushBytes = 0;
+}
+
+bool Sh1107Display::flushNextPage()
+{
+  const uint8_t pages = (HEIGHT + 7) / 8;
+  if (m_flushPage < pages)
+  {
+    const uint8_t  page   = m_flushPage++;
+    const uint16_t offset = static_cast<uint16_t>(page) * WIDTH;
+    m_flushBytes += flushFrameDiff(buffer + offset, m_shadow + offset, m_shadowValid, WIDTH, 1, MERGE_GAP,
+                                   [this, page](uint8_t, uint8_t column, const uint8_t *data, uint8_t length)
+                                   {
+                                     sendRun(page, column, data, length);
+                                   });
+  }
+  if (m_flushPage < pages)
+  {
+    return false;
+  }
+
+  m_shadowValid    = true;
+  m_lastFlushBytes = m_flushBytes;
+
+  // the dirty window of the base class is not used, keep it reset
+  window_x1 = 1024;
+  window_y1 = 1024;
+  window_x2 = -1;
+  window_y2 = -1;
+  return true;
+}
+
+void Sh1107Display::invalidate()
+{
+  m_shadowValid = false;
+}
+
+uint16_t Sh1107Display::lastFlushBytes() const
+{
+  return m_lastFlushBytes;
+}
+
+void Sh1107Display::sendRun(uint8_t page, uint8_t column, const uint8_t *data, uint8_t length)
+{
+  const uint8_t start = column + _page_start_offset;
+  const uint8_t cmd[] = { 0x00, static_cast<uint8_t>(SH110X_SETPAGEADDR + page), static_cast<uint8_t>(0x10 + (start >> 4)),
+                          static_cast<uint8_t>(start & 0xF) };
+  i2c_dev->write(cmd, sizeof(cmd));
+
+  const uint8_t maxChunk = static_cast<uint8_t>(i2c_dev->maxBufferSize() - 1);
+  while (length > 0)
+  {
+    const uint8_t chunk = (length < maxChunk) ? length : maxChunk;
+    i2c_dev->write(data, chunk, true, &DATA_PREFIX, 1);
+    data   += chunk;
+    length -= chunk;
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SH110X.h>
+
+// SH1107 driver that remembers what the panel currently shows. display()
+// compares the framebuffer with that shadow page by page and only sends the
+// column ranges that changed, so an unchanged frame costs no I2C traffic.
+// The same flush can be run a page at a time with startFlush() and
+// flushNextPage(); the framebuffer must not change until it is complete.
+class Sh1107Display : public Adafruit_SH1107
+{
+public:
+  Sh1107Display(uint16_t width, uint16_t height, TwoWire *wire, int8_t resetPin);
+
+  bool begin(uint8_t address, bool reset);
+  void display();
+
+  void startFlush();
+  bool flushNextPage(); // true once the last page is sent
+
+  // Forces the next display() to resend everything, e.g. after a panel reset.
+  void invalidate();
+
+  // Framebuffer bytes sent by the last display() call.
+  uint16_t lastFlushBytes() const;
+
+private:
+  static constexpr uint16_t kMaxWidth  = 128;
+  static constexpr uint16_t kMaxHeight = 128;
+
+  void sendRun(uint8_t page, uint8_t column, const uint8_t *data, uint8_t length);
+
+  uint8_t  m_shadow[kMaxWidth * kMaxHeight / 8];
+  bool     m_shadowValid;
+  uint8_t  m_flushPage;
+  uint16_t m_flushBytes;
+  uint16_t m_lastFlushBytes;
+};
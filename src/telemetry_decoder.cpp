@@ -0,0 +1,193 @@
+// Host-side recorder for SERIAL_OUTPUT = SerialOutput::Binary (see main.cpp).
+//
+//   pio run -e tools_telemetry_decoder
+//   stty -F /dev/ttyACM1 115200 raw -echo
+//   .pio/build/tools_telemetry_decoder/program /dev/ttyACM1 samples.csv
+//
+// Writes one CSV row per valid frame (to stdout without a file argument) and
+// reports received, lost and corrupt frames on stderr. Ctrl-C ends the
+// recording and prints the totals.
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "telemetry_frame.h"
+
+namespace
+{
+  volatile sig_atomic_t stopRequested = 0;
+
+  void onSignal(int)
+  {
+    stopRequested = 1;
+  }
+
+  template <typename Scale>
+  double toBase(int64_t raw)
+  {
+    return static_cast<double>(raw) * detail::pow10(Scale::kExp10) * Scale::kNum / Scale::kDen;
+  }
+
+  struct Counters
+  {
+    uint64_t frames   = 0;
+    uint64_t lost     = 0; // sequence gaps
+    uint64_t corrupt  = 0; // COBS, length or CRC errors
+    uint64_t restarts = 0; // sequence went backwards: the meter rebooted
+  };
+
+  class Recorder
+  {
+  public:
+    explicit Recorder(FILE *csv)
+        : m_csv(csv)
+        , m_length(0)
+        , m_synced(false)
+        , m_overflow(false)
+        , m_hasSequence(false)
+        , m_nextSequence(0)
+    {
+      fprintf(m_csv, "sequence,timestamp_us,vshunt_v,vbus_v,current_a,die_temp_c,energy_j,charge_c\n");
+    }
+
+    void feed(uint8_t byte)
+    {
+      if (byte != 0)
+      {
+        if (m_length < sizeof(m_frame))
+          m_frame[m_length++] = byte;
+        else
+          m_overflow = true;
+        return;
+      }
+
+      // bytes before the first delimiter are boot text or a partial frame
+      if (m_synced && m_length > 0)
+      {
+        handleFrame();
+      }
+      m_synced   = true;
+      m_length   = 0;
+      m_overflow = false;
+    }
+
+    const Counters &counters() const
+    {
+      return m_counters;
+    }
+
+  private:
+    void handleFrame()
+    {
+      telemetry::Sample sample;
+      if (m_overflow || !telemetry::decodeSample(m_frame, m_length, sample))
+      {
+        ++m_counters.corrupt;
+        return;
+      }
+
+      if (m_hasSequence)
+      {
+        const int32_t gap = static_cast<int32_t>(sample.sequence - m_nextSequence);
+        if (gap > 0)
+          m_counters.lost += static_cast<uint32_t>(gap);
+        else if (gap < 0)
+          ++m_counters.restarts;
+      }
+      m_hasSequence  = true;
+      m_nextSequence = sample.sequence + 1;
+      ++m_counters.frames;
+
+      const InaValues &v = sample.values;
+      fprintf(m_csv, "%lu,%lu,%.9g,%.9g,%.9g,%.4f,%.9g,%.9g\n",
+              static_cast<unsigned long>(sample.sequence),
+              static_cast<unsigned long>(sample.timestampUs),
+              toBase<ina::ShuntVoltageScale>(v.vShunt),
+              toBase<ina::BusVoltageScale>(v.vBus),
+              toBase<ina::CurrentScale>(v.current),
+              toBase<ina::DieTempScale>(v.dieTemp),
+              toBase<ina::EnergyScale>(static_cast<int64_t>(v.energy)),
+              toBase<ina::ChargeScale>(v.charge));
+    }
+
+    FILE    *m_csv;
+    uint8_t  m_frame[telemetry::kMaxFrameSize];
+    size_t   m_length;
+    bool     m_synced;
+    bool     m_overflow;
+    bool     m_hasSequence;
+    uint32_t m_nextSequence;
+    Counters m_counters;
+  };
+
+  void printCounters(const Counters &counters)
+  {
+    fprintf(stderr, "frames=%llu lost=%llu corrupt=%llu restarts=%llu\n",
+            static_cast<unsigned long long>(counters.frames),
+            static_cast<unsigned long long>(counters.lost),
+            static_cast<unsigned long long>(counters.corrupt),
+            static_cast<unsigned long long>(counters.restarts));
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2 || argc > 3)
+  {
+    fprintf(stderr, "usage: %s <serial device | - > [output.csv]\n", argv[0]);
+    return 2;
+  }
+
+  FILE *input = (strcmp(argv[1], "-") == 0) ? stdin : fopen(argv[1], "rb");
+  if (input == nullptr)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  FILE *csv = (argc == 3) ? fopen(argv[2], "w") : stdout;
+  if (csv == nullptr)
+  {
+    perror(argv[2]);
+    return 1;
+  }
+
+  // no SA_RESTART, so a blocking read returns on Ctrl-C
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = onSignal;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  Recorder recorder(csv);
+  uint64_t lastReport = 0;
+  uint8_t  chunk[256];
+
+  while (!stopRequested)
+  {
+    const size_t length = fread(chunk, 1, sizeof(chunk), input);
+    if (length == 0)
+    {
+      break;
+    }
+
+    for (size_t i = 0; i < length; ++i)
+    {
+      recorder.feed(chunk[i]);
+    }
+
+    if (recorder.counters().frames >= lastReport + 1000)
+    {
+      lastReport = recorder.counters().frames;
+      printCounters(recorder.counters());
+      fflush(csv);
+    }
+  }
+
+  printCounters(recorder.counters());
+  if (csv != stdout)
+    fclose(csv);
+  return 0;
+}
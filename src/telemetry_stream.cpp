@@ -0,0 +1,65 @@
+#include "telemetry_stream.h"
+
+TelemetryStream::TelemetryStream()
+    : m_buffer()
+    , m_head(0)
+    , m_count(1)
+    , m_dropped(0)
+{
+  // leading delimiter, so the first frame is not glued to the boot messages
+  m_buffer[0] = 0;
+}
+
+void TelemetryStream::publish(const telemetry::Sample &sample)
+{
+  uint8_t      frame[telemetry::kMaxFrameSize];
+  const size_t length = telemetry::encodeSample(sample, frame, sizeof(frame));
+
+  // whole frames only, a partial one would corrupt its neighbour too
+  if (length == 0 || kBufferSize - m_count < length)
+  {
+    ++m_dropped;
+    return;
+  }
+
+  size_t tail = (m_head + m_count) % kBufferSize;
+  for (size_t i = 0; i < length; ++i)
+  {
+    m_buffer[tail] = frame[i];
+    tail           = (tail + 1 < kBufferSize) ? tail + 1 : 0;
+  }
+  m_count += length;
+}
+
+bool TelemetryStream::pending() const
+{
+  return m_count > 0;
+}
+
+void TelemetryStream::drain(Print &out)
+{
+  while (m_count > 0)
+  {
+    const int room = out.availableForWrite();
+    if (room <= 0)
+    {
+      return;
+    }
+
+    // contiguous part of the ring up to the wrap point
+    size_t chunk = kBufferSize - m_head;
+    if (chunk > m_count)
+      chunk = m_count;
+    if (chunk > static_cast<size_t>(room))
+      chunk = static_cast<size_t>(room);
+
+    out.write(m_buffer + m_head, chunk);
+    m_head   = (m_head + chunk) % kBufferSize;
+    m_count -= chunk;
+  }
+}
+
+uint32_t TelemetryStream::dropped() const
+{
+  return m_dropped;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "telemetry_frame.h"
+
+// Binary counterpart of SerialLogger: publish() encodes a frame into a byte
+// ring (or drops it when full), drain() writes only what the UART TX FIFO
+// can take. Lost frames show up on the host as sequence gaps.
+class TelemetryStream
+{
+public:
+  static constexpr size_t kBufferSize = 512;
+
+  TelemetryStream();
+
+  void publish(const telemetry::Sample &sample);
+
+  bool pending() const;
+  void drain(Print &out);
+
+  uint32_t dropped() const;
+
+private:
+  uint8_t  m_buffer[kBufferSize];
+  size_t   m_head; // next byte to send
+  size_t   m_count;
+  uint32_t m_dropped;
+};
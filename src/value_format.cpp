@@ -14,6 +14,197 @@ namespace
   };
 
   constexpr size_t kPrefixCount = sizeof(kPrefixes) / sizeof(kPrefixes[0]);
+
+  constexpr int kPrefixExp10[kPrefixCount] = { -9, -6, -3, 0, 3 };
+
+  constexpr uint64_t kPow10[] = {
+      1ULL,
+      10ULL,
+      100ULL,
+      1000ULL,
+      10000ULL,
+      100000ULL,
+      1000000ULL,
+      10000000ULL,
+      100000000ULL,
+      1000000000ULL,
+      10000000000ULL,
+      100000000000ULL,
+      1000000000000ULL,
+      10000000000000ULL,
+      100000000000000ULL,
+      1000000000000000ULL,
+      10000000000000000ULL,
+      100000000000000000ULL,
+      1000000000000000000ULL,
+  };
+
+  constexpr int kMaxPow10 = sizeof(kPow10) / sizeof(kPow10[0]) - 1;
+
+  // Bounded append-only writer over the caller's buffer.
+  class TextWriter
+  {
+  public:
+    TextWriter(char *buffer, size_t size)
+        : m_buffer(buffer)
+        , m_size(size)
+        , m_length(0)
+    {
+      if (m_size > 0)
+        m_buffer[0] = '\0';
+    }
+
+    void put(char c)
+    {
+      if (m_length + 1 < m_size)
+      {
+        m_buffer[m_length++] = c;
+        m_buffer[m_length]   = '\0';
+      }
+    }
+
+    void put(const char *text)
+    {
+      while (*text != '\0')
+        put(*text++);
+    }
+
+    // `minDigits` zero-pads, like "%02u"
+    void putUnsigned(uint64_t value, uint8_t minDigits = 1)
+    {
+      char    digits[20];
+      uint8_t count = 0;
+      do
+      {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+      } while (value != 0 && count < sizeof(digits));
+
+      while (count < minDigits)
+      {
+        put('0');
+        --minDigits;
+      }
+      while (count > 0)
+        put(digits[--count]);
+    }
+
+    size_t length() const
+    {
+      return m_length;
+    }
+
+  private:
+    char  *m_buffer;
+    size_t m_size;
+    size_t m_length;
+  };
+
+  uint8_t decimalsFor(uint8_t digits, bool atLeast100, bool atLeast10)
+  {
+    if (atLeast100) return digits - 3;
+    if (atLeast10)  return digits - 2;
+    return digits - 1;
+  }
+
+  uint8_t clampDigits(uint8_t digits)
+  {
+    return (digits < 4) ? 4 : (digits > 10) ? 10 : digits;
+  }
+
+  void writeUnit(TextWriter &out, const char *prefix, const char *baseUnit)
+  {
+    if (baseUnit == nullptr || baseUnit[0] == '\0')
+      return;
+
+    // append prefix to baseUnit and pad to exactly 3 characters for alignment
+    out.put(' ');
+    size_t unitLength = 0;
+    for (const char *p = prefix; *p != '\0' && unitLength < 3; ++p, ++unitLength)
+      out.put(*p);
+    for (const char *p = baseUnit; *p != '\0' && unitLength < 3; ++p, ++unitLength)
+      out.put(*p);
+    for (; unitLength < 3; ++unitLength)
+      out.put(' ');
+  }
+
+  // "<int>.<decimals> <unit>" from a value already rounded to `decimals` places
+  void writeNumber(TextWriter &out, bool negative, uint64_t scaledInt, uint8_t decimals, const char *prefix, const char *baseUnit)
+  {
+    if (negative)
+      out.put('-');
+
+    out.putUnsigned(scaledInt / kPow10[decimals]);
+    if (decimals > 0)
+    {
+      out.put('.');
+      out.putUnsigned(scaledInt % kPow10[decimals], decimals);
+    }
+
+    writeUnit(out, prefix, baseUnit);
+  }
+
+  // round(mantissa * 2^exp2 * 10^decimals), ties to even like printf
+  bool roundBinary(uint32_t mantissa, int exp2, uint8_t decimals, uint64_t &result)
+  {
+    const uint64_t product = static_cast<uint64_t>(mantissa) * kPow10[decimals]; // < 2^58
+
+    if (exp2 >= 0)
+    {
+      if (exp2 >= 64 || (product >> (63 - exp2)) != 0)
+        return false;
+      result = product << exp2;
+      return true;
+    }
+
+    const int shift = -exp2;
+    if (shift >= 64)
+    {
+      result = 0;
+      return true;
+    }
+
+    const uint64_t half      = 1ULL << (shift - 1);
+    const uint64_t remainder = product & ((half << 1) - 1);
+    result                   = product >> shift;
+    if (remainder > half || (remainder == half && (result & 1) != 0))
+      ++result;
+    return true;
+  }
+
+  void writeFloat(TextWriter &out, float value, uint8_t decimals, const char *prefix, const char *baseUnit)
+  {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const bool     negative = (bits >> 31) != 0;
+    const uint32_t exponent = (bits >> 23) & 0xFF;
+    const uint32_t fraction = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF)
+    {
+      if (negative)
+        out.put('-');
+      out.put(fraction != 0 ? "nan" : "inf");
+      writeUnit(out, prefix, baseUnit);
+      return;
+    }
+
+    // exact binary value: mantissa * 2^exp2
+    const uint32_t mantissa = (exponent == 0) ? fraction : (fraction | 0x800000);
+    const int      exp2     = (exponent == 0) ? -149 : static_cast<int>(exponent) - 150;
+
+    uint64_t rounded = 0;
+    if (!roundBinary(mantissa, exp2, decimals, rounded))
+    {
+      // beyond ~1e9 kilo-units; not reachable by this meter
+      out.put(negative ? "-ovf" : "ovf");
+      writeUnit(out, prefix, baseUnit);
+      return;
+    }
+
+    writeNumber(out, negative, rounded, decimals, prefix, baseUnit);
+  }
 }
 
 ValuePrefix findValuePrefix(float absValue)
@@ -27,80 +218,129 @@ ValuePrefix findValuePrefix(float absValue)
   return kPrefixes[index];
 }
 
-String formatValue(float baseValue, const char *baseUnit, uint8_t digits)
+size_t formatValue(char *buffer, size_t size, float baseValue, const char *baseUnit, uint8_t digits)
 {
-  digits = constrain(digits, 4, 10);
+  TextWriter out(buffer, size);
+  digits = clampDigits(digits);
 
-  const ValuePrefix prefix  = findValuePrefix(baseValue);
+  const ValuePrefix prefix = findValuePrefix(baseValue);
 
   const float scaled    = baseValue / prefix.factor;
   const float absScaled = fabsf(scaled);
 
-  uint8_t decimals;
-  if      (absScaled >= 100.0f) decimals = digits - 3;
-  else if (absScaled >= 10.0f)  decimals = digits - 2;
-  else                          decimals = digits - 1;
- 
-  char buffer[24];
-  if (baseUnit != nullptr && baseUnit[0] != '\0')
+  const uint8_t decimals = decimalsFor(digits, absScaled >= 100.0f, absScaled >= 10.0f);
+
+  writeFloat(out, scaled, decimals, prefix.symbol, baseUnit);
+  return out.length();
+}
+
+size_t formatDecimal(char *buffer, size_t size, float value, uint8_t decimals)
+{
+  TextWriter out(buffer, size);
+  writeFloat(out, value, (decimals > 9) ? 9 : decimals, "", nullptr);
+  return out.length();
+}
+
+size_t formatFixed(char *buffer, size_t size, int64_t value, int exp10, const char *baseUnit, uint8_t digits)
+{
+  TextWriter out(buffer, size);
+  digits = clampDigits(digits);
+
+  const bool     negative = value < 0;
+  const uint64_t absValue = negative ? static_cast<uint64_t>(-(value + 1)) + 1 : static_cast<uint64_t>(value);
+
+  // |value| * 10^exp10 >= 10^threshold, done on integers
+  auto atLeast = [&](int threshold) -> bool
   {
-    // append prefix to baseUnit and pad to exactly 3 characters for alignment
-    char       unit[4] = { 0 };
-    snprintf(unit, sizeof(unit), "%s%s", prefix.symbol, baseUnit);
+    const int shift = threshold - exp10;
+    if (shift <= 0)
+      return absValue != 0;
+    if (shift > kMaxPow10)
+      return false;
+    return absValue >= kPow10[shift];
+  };
+
+  size_t index = 0;
+  while (index + 1 < kPrefixCount && atLeast(kPrefixExp10[index + 1]))
+    ++index;
+
+  const int     prefixExp10 = kPrefixExp10[index];
+  const uint8_t decimals    = decimalsFor(digits, atLeast(prefixExp10 + 2), atLeast(prefixExp10 + 1));
 
-    size_t len = strlen(unit);
-    while (len < 3 && len < sizeof(unit) - 1)
+  // rescale |value| from 10^exp10 to 10^(prefix - decimals) units
+  const int shift   = exp10 - prefixExp10 + decimals;
+  uint64_t  rounded = absValue;
+  if (shift > 0)
+  {
+    if (shift > kMaxPow10 || absValue > UINT64_MAX / kPow10[shift])
     {
-      unit[len]     = ' ';
-      unit[len + 1] = '\0';
-      ++len;
+      out.put(negative ? "-ovf" : "ovf");
+      writeUnit(out, kPrefixes[index].symbol, baseUnit);
+      return out.length();
     }
-
-    snprintf(buffer, sizeof(buffer), "%.*f %s", decimals, scaled, unit);
+    rounded = absValue * kPow10[shift];
   }
-  else
+  else if (shift < 0)
   {
-    snprintf(buffer, sizeof(buffer), "%.*f", decimals, scaled);
+    if (-shift > kMaxPow10)
+    {
+      rounded = 0;
+    }
+    else
+    {
+      const uint64_t divisor   = kPow10[-shift];
+      const uint64_t remainder = absValue % divisor;
+      rounded                  = absValue / divisor;
+      if (remainder * 2 > divisor || (remainder * 2 == divisor && (rounded & 1) != 0))
+        ++rounded;
+    }
   }
 
-  return String(buffer);
+  writeNumber(out, negative, rounded, decimals, kPrefixes[index].symbol, baseUnit);
+  return out.length();
 }
 
-String formatTime(float seconds)
+size_t formatTime(char *buffer, size_t size, uint32_t totalSeconds)
 {
-  if (seconds < 0.0f)
-  {
-    seconds = 0.0f;
-  }
-
-  unsigned long totalSeconds = static_cast<unsigned long>(seconds + 0.5f);
-  unsigned int  hours        = totalSeconds / 3600;
-  unsigned int  minutes      = (totalSeconds % 3600) / 60;
-  unsigned int  secs         = totalSeconds % 60;
+  TextWriter   out(buffer, size);
+  unsigned int hours   = totalSeconds / 3600;
+  unsigned int minutes = (totalSeconds % 3600) / 60;
+  unsigned int secs    = totalSeconds % 60;
 
+  // beyond 99 hours (long-term history) switch to days with minute resolution
   if (hours > 99)
   {
-    hours   = 99;
-    minutes = 59;
-    secs    = 59;
-  }
+    unsigned int days = totalSeconds / 86400;
+    hours             = (totalSeconds % 86400) / 3600;
 
-  char   chunk[8];
-  String result;
+    if (days > 99)
+    {
+      days    = 99;
+      hours   = 23;
+      minutes = 59;
+    }
+
+    out.putUnsigned(days, 2);
+    out.put('d');
+    out.putUnsigned(hours, 2);
+    out.put('h');
+    out.putUnsigned(minutes, 2);
+    out.put('m');
+    return out.length();
+  }
 
   if (hours > 0)
   {
-    snprintf(chunk, sizeof(chunk), "%02uh", hours);
-    result += chunk;
+    out.putUnsigned(hours, 2);
+    out.put('h');
   }
   if (minutes > 0)
   {
-    snprintf(chunk, sizeof(chunk), "%02um", minutes);
-    result += chunk;
+    out.putUnsigned(minutes, 2);
+    out.put('m');
   }
 
-  snprintf(chunk, sizeof(chunk), "%02us", secs);
-  result += chunk;
-
-  return result;
+  out.putUnsigned(secs, 2);
+  out.put('s');
+  return out.length();
 }
@@ -1,38 +1,372 @@
 #include "webinterface.h"
 
+#include "alert_events.h"
+#include "burst_capture.h"
+#include "compressed_history.h"
+#include "energy_log.h"
+#include "ina_channel.h"
 #include "ina_values.h"
+#include "measurement_history.h"
+#include "profiler.h"
+#include "scheduler.h"
+#include "tiered_history.h"
+#include "trigger_capture.h"
 #include "value_format.h"
-#include <math.h>
 
 WebInterface::WebInterface()
     : m_server(80)
-    , m_lastMeasurementHtml(F("<h1>Power Meter</h1><p>No measurements yet.</p>"))
+    , m_lastValues()
+    , m_lastEnergyDelta(0)
+    , m_sequence(0)
+    , m_bootTag(0)
     , m_webReady(false)
     , m_connected(false)
     , m_localIp()
-    , m_lastEnergyWs(NAN)
+    , m_lastEnergy(0)
+    , m_hasLastEnergy(false)
+    , m_history(nullptr)
+    , m_samples(nullptr)
+    , m_archive(nullptr)
+    , m_burst(nullptr)
+    , m_channels(nullptr)
+    , m_channelCount(0)
+    , m_trigger(nullptr)
+    , m_energyLog(nullptr)
+    , m_profiler(nullptr)
+    , m_scheduler(nullptr)
 {
 }
 
-String WebInterface::buildPage() const
+namespace
 {
-  String html;
-  html.reserve(384);
-  html += F("<!DOCTYPE html><html><head><meta charset='utf-8'><meta http-equiv='refresh' content='1'>"
-            "<title>Power Meter</title>");
-  html += F("<style>body{font-family:sans-serif;margin:1.5em;}h1{font-size:1.5em;}table{border-collapse:collapse;margin-bottom:1em;}td,th{padding:0.25em 0.5em;border:1px solid #ccc;}th{text-align:left;background:#f7f7f7;}td:last-child{text-align:right;}</style>");
-  html += F("</head><body>");
-  html += m_lastMeasurementHtml;
+  const char kPageStyle[] PROGMEM =
+      "<style>body{font-family:sans-serif;margin:1.5em;}h1{font-size:1.5em;}table{border-collapse:collapse;margin-bottom:1em;}td,th{padding:0.25em 0.5em;border:1px solid #ccc;}th{text-align:left;background:#f7f7f7;}td:last-child{text-align:right;}</style>";
 
-  if (WiFi.status() == WL_CONNECTED)
+  // browsers with EventSource get pushed updates, the rest keep polling
+  const char kPageHead[] PROGMEM =
+      "<!DOCTYPE html><html><head><meta charset='utf-8'><noscript><meta http-equiv='refresh' content='1'></noscript>"
+      "<title>Power Meter</title>";
+  const char kPageIntro[] PROGMEM     = "</head><body><h1>Power Meter</h1>";
+  const char kNoMeasurement[] PROGMEM = "<p>No measurements yet.</p>";
+  const char kLastTable[] PROGMEM     = "<table><tr><th colspan='2'>Last measurement</th></tr>";
+  const char kTotalTable[] PROGMEM    = "</table><table><tr><th colspan='2'>Total energy</th></tr>";
+  const char kTableEnd[] PROGMEM      = "</table>";
+  const char kChannelTable[] PROGMEM =
+      "<table><tr><th>Channel</th><th>Current</th><th>Vbus</th><th>Energy</th><th>Alerts</th></tr>";
+  const char kHistoryLinks[] PROGMEM =
+      "<p>History: <a href='/history?tier=hour'>hour</a> | <a href='/history?tier=day'>day</a> | "
+      "<a href='/history?tier=week'>week</a></p>";
+  const char kPageEnd[] PROGMEM =
+      "<script>if(window.EventSource){new EventSource('/events').onmessage=function(e){"
+      "if(!document.getElementById('current')){location.reload();return;}"
+      "var d=JSON.parse(e.data);for(var k in d){document.getElementById(k).textContent=d[k];}};}</script>"
+      "</body></html>";
+
+  const char kEventStreamHeader[] PROGMEM =
+      "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+      "Connection: keep-alive\r\n\r\nretry: 2000\n\n";
+
+  // a stream client that could not take a frame for this long is dropped
+  constexpr uint32_t kStreamStallMs = 10000;
+
+  const char *kCollectedHeaders[] = { "If-None-Match" };
+
+  // Fixed-capacity text on the stack; appends past the end are dropped.
+  template <size_t N>
+  class TextBuffer
+  {
+  public:
+    TextBuffer()
+        : m_length(0)
+    {
+      m_text[0] = '\0';
+    }
+
+    void append(const char *text)
+    {
+      while (*text != '\0' && m_length + 1 < N)
+      {
+        m_text[m_length++] = *text++;
+      }
+      m_text[m_length] = '\0';
+    }
+
+    void appendUnsigned(uint32_t value)
+    {
+      char    digits[11];
+      uint8_t count = sizeof(digits) - 1;
+      digits[count] = '\0';
+      do
+      {
+        digits[--count] = static_cast<char>('0' + value % 10);
+        value /= 10;
+      } while (value != 0);
+      append(&digits[count]);
+    }
+
+    const char *c_str() const
+    {
+      return m_text;
+    }
+
+    size_t length() const
+    {
+      return m_length;
+    }
+
+  private:
+    char   m_text[N];
+    size_t m_length;
+  };
+
+  // "23.4 C" from a DIETEMP code, rounded to tenths of a degree
+  TextBuffer<12> temperatureText(int16_t dieTemp)
+  {
+    const int64_t scaled = static_cast<int64_t>(dieTemp) * ina::DieTempScale::kNum; // 1e-7 degC
+    const int64_t tenths = (scaled >= 0) ? (scaled + 500000) / 1000000 : (scaled - 500000) / 1000000;
+
+    TextBuffer<12> text;
+    if (tenths < 0)
+    {
+      text.append("-");
+    }
+    const uint32_t absTenths = static_cast<uint32_t>(tenths < 0 ? -tenths : tenths);
+    text.appendUnsigned(absTenths / 10);
+    text.append(".");
+    text.appendUnsigned(absTenths % 10);
+    text.append(" C");
+    return text;
+  }
+
+  // "none", "3" or "3, SHNTOL active", summed over the channels
+  TextBuffer<40> alertText(const InaChannel *channels, size_t count)
+  {
+    uint32_t total  = 0;
+    uint16_t active = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+      total += channels[i].alerts.total();
+      active |= channels[i].alerts.active();
+    }
+
+    TextBuffer<40> text;
+    if (total == 0)
+    {
+      text.append("none");
+      return text;
+    }
+
+    text.appendUnsigned(total);
+    if (active != 0)
+    {
+      text.append(",");
+      forEachAlertFlag(active,
+                       [&](const char *name)
+                       {
+                         text.append(" ");
+                         text.append(name);
+                       });
+      text.append(" active");
+    }
+    return text;
+  }
+
+  // FNV-1a over the bytes of `value`, chained through `hash`
+  uint32_t mixTag(uint32_t hash, uint32_t value)
+  {
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      hash = (hash ^ (value & 0xFF)) * 16777619UL;
+      value >>= 8;
+    }
+    return hash;
+  }
+
+  // Chunked response body assembled in a small stack buffer, so a page costs a
+  // handful of TCP writes and no heap allocations.
+  class ChunkedResponse
+  {
+  public:
+    explicit ChunkedResponse(ESP8266WebServer &server)
+        : m_server(server)
+        , m_length(0)
+    {
+    }
+
+    void append(const char *text)
+    {
+      while (*text != '\0')
+      {
+        put(*text++);
+      }
+    }
+
+    void appendP(PGM_P text)
+    {
+      for (char c = pgm_read_byte(text); c != '\0'; c = pgm_read_byte(++text))
+      {
+        put(c);
+      }
+    }
+
+    void appendUnsigned(uint64_t value)
+    {
+      char    digits[20];
+      uint8_t count = 0;
+      do
+      {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+      } while (value != 0);
+
+      while (count > 0)
+      {
+        put(digits[--count]);
+      }
+    }
+
+    void appendSigned(int64_t value)
+    {
+      if (value < 0)
+      {
+        put('-');
+        appendUnsigned(static_cast<uint64_t>(-(value + 1)) + 1);
+        return;
+      }
+      appendUnsigned(static_cast<uint64_t>(value));
+    }
+
+    // microseconds as exact decimal seconds, "0.000250"
+    void appendSeconds(uint64_t us)
+    {
+      appendUnsigned(us / 1000000);
+      put('.');
+      const uint32_t fraction = static_cast<uint32_t>(us % 1000000);
+      for (uint32_t digit = 100000; digit > 0; digit /= 10)
+      {
+        put(static_cast<char>('0' + fraction / digit % 10));
+      }
+    }
+
+    void appendLittleEndian(uint64_t value, uint8_t bytes)
+    {
+      for (uint8_t i = 0; i < bytes; ++i)
+      {
+        put(static_cast<char>(value & 0xFF));
+        value >>= 8;
+      }
+    }
+
+    // `id` lets the page script update the cell in place
+    void appendRow(PGM_P label, PGM_P id, const char *value)
+    {
+      appendP(PSTR("<tr><td>"));
+      appendP(label);
+      appendP(PSTR("</td><td id='"));
+      appendP(id);
+      appendP(PSTR("'>"));
+      append(value);
+      appendP(PSTR("</td></tr>"));
+    }
+
+    // Flushes the buffer and terminates the chunked body.
+    void finish()
+    {
+      flush();
+      m_server.sendContent("");
+    }
+
+  private:
+    void put(char c)
+    {
+      if (m_length == sizeof(m_buffer))
+      {
+        flush();
+      }
+      m_buffer[m_length++] = c;
+    }
+
+    void flush()
+    {
+      if (m_length > 0)
+      {
+        m_server.sendContent(m_buffer, m_length);
+        m_length = 0;
+      }
+    }
+
+    ESP8266WebServer &m_server;
+    char              m_buffer[256];
+    size_t            m_length;
+  };
+}
+
+namespace
+{
+  // "# HELP" and "# TYPE" lines of a Prometheus metric family
+  void appendMetricHeader(ChunkedResponse &out, PGM_P name, PGM_P type, PGM_P help)
   {
-    html += F("<p>IP: ");
-    html += WiFi.localIP().toString();
-    html += F("</p>");
+    out.appendP(PSTR("# HELP "));
+    out.appendP(name);
+    out.append(" ");
+    out.appendP(help);
+    out.appendP(PSTR("\n# TYPE "));
+    out.appendP(name);
+    out.append(" ");
+    out.appendP(type);
+    out.append("\n");
   }
 
-  html += F("</body></html>");
-  return html;
+  // a family with a single unlabelled sample
+  void appendMetric(ChunkedResponse &out, PGM_P name, PGM_P type, PGM_P help, uint64_t value)
+  {
+    appendMetricHeader(out, name, type, help);
+    out.appendP(name);
+    out.append(" ");
+    out.appendUnsigned(value);
+    out.append("\n");
+  }
+
+  // "name_bucket{label,le=...}", "name_sum{label}" and "name_count{label}"
+  // of one labelled histogram
+  void appendHistogramSeries(ChunkedResponse &out, PGM_P name, PGM_P labelName, const char *labelValue,
+                             const LatencyHistogram &histogram)
+  {
+    const auto appendSeries = [&](PGM_P suffix, bool more)
+    {
+      out.appendP(name);
+      out.appendP(suffix);
+      out.append("{");
+      out.appendP(labelName);
+      out.append("=\"");
+      out.append(labelValue);
+      out.append(more ? "\"," : "\"");
+    };
+
+    uint32_t cumulative = 0;
+    for (size_t bucket = 0; bucket < LatencyHistogram::kBucketCount; ++bucket)
+    {
+      cumulative += histogram.bucket(bucket);
+      appendSeries(PSTR("_bucket"), true);
+      out.appendP(PSTR("le=\""));
+      if (bucket < LatencyHistogram::kBoundCount)
+        out.appendSeconds(LatencyHistogram::kBoundsUs[bucket]);
+      else
+        out.append("+Inf");
+      out.append("\"} ");
+      out.appendUnsigned(cumulative);
+      out.append("\n");
+    }
+
+    appendSeries(PSTR("_sum"), false);
+    out.append("} ");
+    out.appendSeconds(histogram.sumUs());
+    out.append("\n");
+    appendSeries(PSTR("_count"), false);
+    out.append("} ");
+    out.appendUnsigned(histogram.count());
+    out.append("\n");
+  }
 }
 
 bool WebInterface::begin(const char *ssid, const char *password)
@@ -59,64 +393,510 @@ bool WebInterface::begin(const char *ssid, const char *password)
   }
 
   m_localIp = WiFi.localIP();
+  m_bootTag = ESP.random(); // hardware RNG, random once the radio is on
 
   Serial.print(F("Connected! IP: "));
   Serial.println(m_localIp);
 
-  m_server.on("/",
-              [this]()
-              {
-                m_server.send(200, "text/html", buildPage());
-              });
+  route("/", &WebInterface::sendMainPage);
+  route("/history", &WebInterface::sendHistoryPage);
+  route("/api/samples", &WebInterface::sendSamples);
+  route("/api/burst", &WebInterface::sendBurst);
+  route("/api/alerts", &WebInterface::sendAlerts);
+  route("/api/trigger", &WebInterface::sendTrigger);
+  route("/api/energy-log", &WebInterface::sendEnergyLog);
+  route("/events", &WebInterface::acceptStreamClient);
+  route("/metrics", &WebInterface::sendMetrics);
+  m_server.collectHeaders(kCollectedHeaders, 1);
   m_server.begin();
   m_webReady  = true;
   m_connected = true;
   return true;
 }
 
+// every handler is timed as ProfileStage::WebRequest
+void WebInterface::route(const char *uri, void (WebInterface::*handler)())
+{
+  m_server.on(uri,
+              [this, handler]()
+              {
+                ProfileScope scope(m_profiler, ProfileStage::WebRequest);
+                (this->*handler)();
+              });
+}
+
+// ?channel=<index into the configured channels>; false for anything else
+bool WebInterface::channelArg(size_t &index)
+{
+  const String arg = m_server.arg(F("channel"));
+  char        *end = nullptr;
+  index            = strtoul(arg.c_str(), &end, 10);
+  return arg.length() > 0 && *end == '\0' && index < m_channelCount;
+}
+
 void WebInterface::updateMeasurements(const InaValues &values)
 {
-  const float deltaWh = max((!isnan(m_lastEnergyWs)) ? (values.energyWs - m_lastEnergyWs) / 3600.0f : 0.0f, 0.0f);
-  const float totalWh = values.energyWs / 3600.0f;
+  // only remember the sample; the page is rendered when a client asks for it
+  m_lastEnergyDelta = (m_hasLastEnergy && values.energy >= m_lastEnergy) ? values.energy - m_lastEnergy : 0;
+  m_lastValues      = values;
+  m_lastEnergy      = values.energy;
+  m_hasLastEnergy   = true;
+  ++m_sequence;
 
-  const String currentStr     = formatValue(values.current_mA / 1000.0f, "A", 5);
-  const String deltaEnergyStr = formatValue(deltaWh, "Wh", 5);
-  const String totalEnergyStr = formatValue(totalWh, "Wh", 5);
-  const String vbusStr        = formatValue(values.vBus, "V", 3);
+  publishMeasurement();
+}
+
+// Server-Sent Events: the handler takes over the connection and answers it
+// directly, the server forgets it once the handler returns.
+void WebInterface::acceptStreamClient()
+{
+  StreamClient *slot = nullptr;
+  for (StreamClient &candidate : m_streamClients)
+  {
+    if (!candidate.active)
+    {
+      slot = &candidate;
+      break;
+    }
+  }
+
+  if (slot == nullptr)
+  {
+    m_server.send(503, "text/plain", F("Too many stream clients"));
+    return;
+  }
+
+  slot->client = m_server.client();
+  slot->client.setNoDelay(true);
+  slot->client.print(FPSTR(kEventStreamHeader));
+  slot->lastWriteMs = millis();
+  slot->active      = true;
+
+  publishMeasurement();
+}
+
+// Every frame carries the full state, so a client that has no room in its
+// TCP window simply skips frames (coalescing to the newest) instead of
+// blocking the acquisition loop; one stalled for too long is dropped.
+void WebInterface::publishMeasurement()
+{
+  bool anyActive = false;
+  for (const StreamClient &stream : m_streamClients)
+  {
+    anyActive = anyActive || stream.active;
+  }
+  if (!anyActive || !m_hasLastEnergy)
+  {
+    return;
+  }
+
+  TextBuffer<232> frame;
+  frame.append("id: ");
+  frame.appendUnsigned(m_sequence);
+  frame.append("\ndata: {\"current\":\"");
+  frame.append(ValueText::fromRaw<ina::CurrentScale>(m_lastValues.current, "A", 5).c_str());
+  frame.append("\",\"energy\":\"");
+  frame.append(ValueText::fromRaw<ina::EnergyWhScale>(static_cast<int64_t>(m_lastEnergyDelta), "Wh", 5).c_str());
+  frame.append("\",\"vbus\":\"");
+  frame.append(ValueText::fromRaw<ina::BusVoltageScale>(m_lastValues.vBus, "V", 3).c_str());
+  frame.append("\",\"temp\":\"");
+  frame.append(temperatureText(m_lastValues.dieTemp).c_str());
+  frame.append("\",\"total\":\"");
+  frame.append(ValueText::fromRaw<ina::EnergyWhScale>(static_cast<int64_t>(m_lastValues.energy), "Wh", 5).c_str());
+  if (m_channelCount > 0)
+  {
+    frame.append("\",\"alerts\":\"");
+    frame.append(alertText(m_channels, m_channelCount).c_str());
+  }
+  frame.append("\"}\n\n");
 
-  String tempStr;
-  tempStr.reserve(12);
-  tempStr += String(values.temperature, 1);
-  tempStr += F(" C");
+  const uint32_t now = millis();
+  for (StreamClient &stream : m_streamClients)
+  {
+    if (!stream.active)
+    {
+      continue;
+    }
+
+    if (stream.client.connected() && static_cast<size_t>(stream.client.availableForWrite()) >= frame.length())
+    {
+      stream.client.write(reinterpret_cast<const uint8_t *>(frame.c_str()), frame.length());
+      stream.lastWriteMs = now;
+    }
+    else if (!stream.client.connected() || now - stream.lastWriteMs > kStreamStallMs)
+    {
+      stream.client.stop();
+      stream.active = false;
+    }
+  }
+}
+
+void WebInterface::sendMainPage()
+{
+  // the page changes with a new total, with a sample or read error of any
+  // channel and with a limit event, which may come without a sample; together
+  // they make a strong validator, the meta refresh then mostly costs a 304
+  uint32_t value = mixTag(2166136261UL, m_sequence);
+  for (size_t i = 0; i < m_channelCount; ++i)
+  {
+    const InaChannel &channel = m_channels[i];
+
+    value = mixTag(value, channel.readings.history.nextSequence());
+    value = mixTag(value, channel.readings.ok ? 1 : 0);
+    value = mixTag(value, channel.alerts.total());
+    value = mixTag(value, channel.alerts.active());
+  }
+
+  // "<boot>-<value>": the counters restart with every boot, the boot tag
+  // keeps a validator from an earlier boot from matching
+  char     etag[20];
+  uint32_t boot = m_bootTag;
+  etag[0]       = '"';
+  for (uint8_t i = 0; i < 8; ++i)
+  {
+    etag[8 - i]  = "0123456789abcdef"[boot & 0xF];
+    etag[17 - i] = "0123456789abcdef"[value & 0xF];
+    boot >>= 4;
+    value >>= 4;
+  }
+  etag[9]  = '-';
+  etag[18] = '"';
+  etag[19] = '\0';
 
-  m_lastMeasurementHtml = F("<h1>Power Meter</h1>");
-  m_lastMeasurementHtml += F("<table><tr><th colspan='2'>Last measurement</th></tr>");
+  m_server.sendHeader(F("ETag"), etag);
+  m_server.sendHeader(F("Cache-Control"), F("no-cache"));
 
-  auto addRow =
-      [&](const __FlashStringHelper *label, const String &value)
+  if (m_server.header(F("If-None-Match")) == etag)
+  {
+    m_server.send(304, "text/html", "");
+    return;
+  }
+
+  m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  m_server.send(200, "text/html", "");
+
+  ChunkedResponse out(m_server);
+  out.appendP(kPageHead);
+  out.appendP(kPageStyle);
+  out.appendP(kPageIntro);
+
+  if (!m_hasLastEnergy)
+  {
+    out.appendP(kNoMeasurement);
+  }
+  else
+  {
+    out.appendP(kLastTable);
+    out.appendRow(PSTR("Current"), PSTR("current"), ValueText::fromRaw<ina::CurrentScale>(m_lastValues.current, "A", 5).c_str());
+    out.appendRow(PSTR("Energy"), PSTR("energy"), ValueText::fromRaw<ina::EnergyWhScale>(static_cast<int64_t>(m_lastEnergyDelta), "Wh", 5).c_str());
+    out.appendRow(PSTR("Vbus"), PSTR("vbus"), ValueText::fromRaw<ina::BusVoltageScale>(m_lastValues.vBus, "V", 3).c_str());
+    out.appendRow(PSTR("Temp"), PSTR("temp"), temperatureText(m_lastValues.dieTemp).c_str());
+    if (m_channelCount > 0)
+    {
+      out.appendRow(PSTR("Alerts"), PSTR("alerts"), alertText(m_channels, m_channelCount).c_str());
+    }
+    out.appendP(kTotalTable);
+    out.appendRow(PSTR("Energy"), PSTR("total"), ValueText::fromRaw<ina::EnergyWhScale>(static_cast<int64_t>(m_lastValues.energy), "Wh", 5).c_str());
+    if (m_energyLog != nullptr && m_energyLog->ready())
+    {
+      // logged buckets plus the one still open
+      uint64_t lifetime = m_energyLog->totalEnergy();
+      if (m_history != nullptr)
       {
-        String row;
-        row.reserve(64);
-        row += F("<tr><td>");
-        row += label;
-        row += F("</td><td>");
-        row += value;
-        row += F("</td></tr>");
-        m_lastMeasurementHtml += row;
-      };
+        lifetime += m_history->openBucket(HistoryTier::Hour).energy;
+      }
+      out.appendRow(PSTR("Lifetime"), PSTR("lifetime"), ValueText::fromRaw<ina::EnergyWhScale>(static_cast<int64_t>(lifetime), "Wh", 5).c_str());
+    }
+    out.appendP(kTableEnd);
+
+    // the tables above are the sum over the channels; one row per channel
+    if (m_channelCount > 1)
+    {
+      out.appendP(kChannelTable);
+      for (size_t i = 0; i < m_channelCount; ++i)
+      {
+        const InaChannel &channel = m_channels[i];
+        const InaValues  &values  = channel.readings.values;
+        out.appendP(PSTR("<tr><td>"));
+        out.append(channel.config->name);
+        out.appendP(PSTR("</td><td>"));
+        if (channel.readings.ok)
+        {
+          out.append(ValueText::fromRaw<ina::CurrentScale>(values.current, "A", 5).c_str());
+          out.appendP(PSTR("</td><td>"));
+          out.append(ValueText::fromRaw<ina::BusVoltageScale>(values.vBus, "V", 3).c_str());
+          out.appendP(PSTR("</td><td>"));
+          out.append(ValueText::fromRaw<ina::EnergyWhScale>(static_cast<int64_t>(values.energy), "Wh", 5).c_str());
+        }
+        else
+        {
+          out.appendP(PSTR("error</td><td></td><td>"));
+        }
+        out.appendP(PSTR("</td><td>"));
+        out.append(alertText(&channel, 1).c_str());
+        out.appendP(PSTR("</td></tr>"));
+      }
+      out.appendP(kTableEnd);
+    }
+  }
+
+  if (m_history != nullptr)
+  {
+    out.appendP(kHistoryLinks);
+  }
+
+  if (WiFi.status() == WL_CONNECTED)
+  {
+    out.appendP(PSTR("<p>IP: "));
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      if (i > 0)
+      {
+        out.append(".");
+      }
+      out.appendUnsigned(m_localIp[i]);
+    }
+    out.appendP(PSTR("</p>"));
+  }
+
+  out.appendP(kPageEnd);
+  out.finish();
+}
+
+void WebInterface::attachHistory(const TieredHistory *history)
+{
+  m_history = history;
+}
+
+void WebInterface::attachSamples(const MeasurementHistory *samples)
+{
+  m_samples = samples;
+}
+
+void WebInterface::attachArchive(const SampleArchive *archive)
+{
+  m_archive = archive;
+}
+
+void WebInterface::attachBurst(BurstCapture *burst)
+{
+  m_burst = burst;
+}
+
+void WebInterface::attachChannels(const InaChannel *channels, size_t count)
+{
+  m_channels     = channels;
+  m_channelCount = count;
+}
+
+void WebInterface::attachTrigger(TriggerCapture *trigger)
+{
+  m_trigger = trigger;
+}
+
+void WebInterface::attachEnergyLog(const EnergyLog *log)
+{
+  m_energyLog = log;
+}
+
+void WebInterface::attachProfiler(Profiler *profiler)
+{
+  m_profiler = profiler;
+}
+
+void WebInterface::attachScheduler(const Scheduler *scheduler)
+{
+  m_scheduler = scheduler;
+}
+
+void WebInterface::sendHistoryPage()
+{
+  if (m_history == nullptr)
+  {
+    m_server.send(404, "text/plain", F("No history available"));
+    return;
+  }
+
+  HistoryTier    tier    = HistoryTier::Hour;
+  const String   tierArg = m_server.arg(F("tier"));
+  for (size_t i = 0; i < TieredHistory::kTierCount; ++i)
+  {
+    if (tierArg == TieredHistory::kTiers[i].name)
+    {
+      tier = static_cast<HistoryTier>(i);
+    }
+  }
+
+  const TieredHistory::TierSpec &spec = TieredHistory::spec(tier);
+
+  // up to 96 rows: stream the table row by row instead of building it in RAM
+  m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  m_server.send(200, "text/html", "");
+
+  ChunkedResponse out(m_server);
+  out.appendP(PSTR("<!DOCTYPE html><html><head><meta charset='utf-8'><title>Power Meter history</title>"));
+  out.appendP(kPageStyle);
+  out.appendP(PSTR("</head><body><h1>History ("));
+  out.append(spec.name);
+  out.appendP(PSTR(", "));
+  out.append(ValueText::time(spec.bucketSeconds).c_str());
+  out.appendP(PSTR(" buckets)</h1><p><a href='/'>back</a></p>"
+                   "<table><tr><th>Start</th><th>Samples</th><th>I min</th><th>I mean</th><th>I max</th><th>Energy</th></tr>"));
+
+  const RingView<HistoryBucket> buckets    = m_history->buckets(tier);
+  const HistoryBucket           openBucket = m_history->openBucket(tier);
+  for (size_t i = buckets.size() + 1; i-- > 0;)
+  {
+    // newest first, starting with the bucket still being filled
+    const HistoryBucket &bucket = (i == buckets.size()) ? openBucket : buckets[i];
+    if (bucket.samples == 0)
+    {
+      continue;
+    }
+
+    out.appendP(PSTR("<tr><td>"));
+    out.append(ValueText::time(bucket.startSeconds).c_str());
+    out.appendP(PSTR("</td><td>"));
+    out.appendUnsigned(bucket.samples);
+    out.appendP(PSTR("</td><td>"));
+    out.append(ValueText::fromRaw<ina::CurrentScale>(bucket.minCurrent, "A", 5).c_str());
+    out.appendP(PSTR("</td><td>"));
+    out.append(ValueText::fromRaw<ina::CurrentScale>(bucket.meanCurrent, "A", 5).c_str());
+    out.appendP(PSTR("</td><td>"));
+    out.append(ValueText::fromRaw<ina::CurrentScale>(bucket.maxCurrent, "A", 5).c_str());
+    out.appendP(PSTR("</td><td>"));
+    out.append(ValueText::fromRaw<ina::EnergyWhScale>(static_cast<int64_t>(bucket.energy), "Wh", 5).c_str());
+    out.appendP(PSTR("</td></tr>"));
+  }
+
+  out.appendP(PSTR("</table></body></html>"));
+  out.finish();
+}
+
+// GET /api/samples?since=<seq>[&format=bin][&channel=<index>]
+//
+// Returns the retained samples of the total with a sequence number >= since,
+// oldest first, from the compressed archive if attached (it reaches further
+// back) or else the sample ring; with channel, from that channel's ring. Poll
+// again with since=<next>. If from > since, samples were lost in between.
+// Values are raw register codes, value = code * num * 10^exp10.
+//
+// JSON: {"from":S,"next":N,"current":[num,exp10],"energy":[num,exp10],
+//        "vbus":[num,exp10],"samples":[[ms,current,energy,vbus],...]}
+// bin:  little-endian header u32 from, u32 next, u16 count, u16 record size,
+//       then per sample u32 ms, i32 current, u64 energy, i32 vbus. Readers
+//       skip what follows the fields they know, using the record size.
+void WebInterface::sendSamples()
+{
+  const MeasurementHistory *samples = m_samples;
+  const SampleArchive      *archive = m_archive;
+  if (m_server.hasArg(F("channel")))
+  {
+    size_t index = 0;
+    if (!channelArg(index))
+    {
+      m_server.send(404, "text/plain", F("Unknown channel"));
+      return;
+    }
+    samples = &m_channels[index].readings.history;
+    archive = nullptr;
+  }
 
-  addRow(F("Current"), currentStr);
-  addRow(F("Energy"), deltaEnergyStr);
-  addRow(F("Vbus"), vbusStr);
-  addRow(F("Temp"), tempStr);
+  if (samples == nullptr && archive == nullptr)
+  {
+    m_server.send(404, "text/plain", F("No samples available"));
+    return;
+  }
+
+  const uint32_t since  = strtoul(m_server.arg(F("since")).c_str(), nullptr, 10);
+  const bool     binary = m_server.arg(F("format")) == "bin";
+  const size_t   count  = (archive != nullptr) ? archive->countSince(since) : samples->countSince(since);
+  const uint32_t next   = (archive != nullptr) ? archive->nextSequence() : samples->nextSequence();
+  const uint32_t from   = next - static_cast<uint32_t>(count);
+
+  // visits (ms, current, energy, vbus) for the samples from `from` on
+  const auto forEachRecord = [&](auto &&visit)
+  {
+    if (archive != nullptr)
+    {
+      archive->forEachSince(since,
+                            [&](uint32_t, const SampleArchive::Sample &sample)
+                            {
+                              visit(sample.timestampMs, sample.current, sample.energy, sample.vBus);
+                            });
+      return;
+    }
 
-  m_lastMeasurementHtml += F("</table>");
+    // the channel rings line up with the retained samples, oldest first
+    const RingView<int32_t> vBus   = samples->channel<history::BusVoltage>();
+    size_t                  vIndex = vBus.size() - count;
+    samples->forEachSince(since,
+                          [&](uint32_t, int32_t current, uint64_t energy, uint32_t timestampMs)
+                          {
+                            visit(timestampMs, current, energy, vBus[vIndex++]);
+                          });
+  };
 
-  m_lastMeasurementHtml += F("<table><tr><th colspan='2'>Total energy</th></tr>");
-  addRow(F("Energy"), totalEnergyStr);
-  m_lastMeasurementHtml += F("</table>");
+  m_server.sendHeader(F("Cache-Control"), F("no-store"));
+  m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  m_server.send(200, binary ? "application/octet-stream" : "application/json", "");
+
+  ChunkedResponse out(m_server);
+
+  if (binary)
+  {
+    out.appendLittleEndian(from, 4);
+    out.appendLittleEndian(next, 4);
+    out.appendLittleEndian(count, 2);
+    out.appendLittleEndian(20, 2);
+    forEachRecord(
+        [&](uint32_t timestampMs, int32_t current, uint64_t energy, int32_t vBus)
+        {
+          out.appendLittleEndian(timestampMs, 4);
+          out.appendLittleEndian(static_cast<uint32_t>(current), 4);
+          out.appendLittleEndian(energy, 8);
+          out.appendLittleEndian(static_cast<uint32_t>(vBus), 4);
+        });
+    out.finish();
+    return;
+  }
+
+  out.appendP(PSTR("{\"from\":"));
+  out.appendUnsigned(from);
+  out.appendP(PSTR(",\"next\":"));
+  out.appendUnsigned(next);
+  out.appendP(PSTR(",\"current\":["));
+  out.appendSigned(ina::CurrentScale::kNum);
+  out.append(",");
+  out.appendSigned(ina::CurrentScale::kExp10);
+  out.appendP(PSTR("],\"energy\":["));
+  out.appendSigned(ina::EnergyScale::kNum);
+  out.append(",");
+  out.appendSigned(ina::EnergyScale::kExp10);
+  out.appendP(PSTR("],\"vbus\":["));
+  out.appendSigned(ina::BusVoltageScale::kNum);
+  out.append(",");
+  out.appendSigned(ina::BusVoltageScale::kExp10);
+  out.appendP(PSTR("],\"samples\":["));
+
+  bool first = true;
+  forEachRecord(
+      [&](uint32_t timestampMs, int32_t current, uint64_t energy, int32_t vBus)
+      {
+        out.append(first ? "[" : ",[");
+        out.appendUnsigned(timestampMs);
+        out.append(",");
+        out.appendSigned(current);
+        out.append(",");
+        out.appendUnsigned(energy);
+        out.append(",");
+        out.appendSigned(vBus);
+        out.append("]");
+        first = false;
+      });
 
-  m_lastEnergyWs = values.energyWs;
+  out.append("]}");
+  out.finish();
 }
 
 void WebInterface::loop()
@@ -139,3 +919,416 @@ bool WebInterface::isConnected() const
 {
   return m_connected;
 }
+
+// GET /api/burst returns the last capture, /api/burst?start=1 queues a new one
+// (it runs from the main loop, poll until "capture" changes).
+void WebInterface::sendBurst()
+{
+  if (m_burst == nullptr)
+  {
+    m_server.send(404, "text/plain", F("Burst capture not available"));
+    return;
+  }
+
+  m_server.sendHeader(F("Cache-Control"), F("no-store"));
+
+  if (m_server.arg(F("start")) == "1")
+  {
+    m_burst->request();
+    TextBuffer<48> body;
+    body.append("{\"requested\":true,\"capture\":");
+    body.appendUnsigned(m_burst->captureId());
+    body.append("}");
+    m_server.send(202, "application/json", body.c_str());
+    return;
+  }
+
+  m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  m_server.send(200, "application/json", "");
+
+  ChunkedResponse out(m_server);
+  out.appendP(PSTR("{\"capture\":"));
+  out.appendUnsigned(m_burst->captureId());
+  out.appendP(PSTR(",\"count\":"));
+  out.appendUnsigned(m_burst->count());
+  out.appendP(PSTR(",\"duration_us\":"));
+  out.appendUnsigned(m_burst->durationUs());
+  out.appendP(PSTR(",\"current\":["));
+  out.appendSigned(ina::CurrentScale::kNum);
+  out.append(",");
+  out.appendSigned(ina::CurrentScale::kExp10);
+  out.appendP(PSTR("],\"samples\":["));
+
+  for (size_t i = 0; i < m_burst->count(); ++i)
+  {
+    out.append(i == 0 ? "[" : ",[");
+    out.appendUnsigned(m_burst->offsetUs(i));
+    out.append(",");
+    out.appendSigned(m_burst->current(i));
+    out.append("]");
+  }
+
+  out.append("]}");
+  out.finish();
+}
+
+// Retained limit events of the first channel, or of ?channel=<index>, oldest
+// first: [timestamp_us, uptime_ms, flags, current, vbus] with raw codes. Flags
+// are the datasheet names, empty for a violation that was over before
+// DIAG_ALRT was read.
+void WebInterface::sendAlerts()
+{
+  size_t index = 0;
+  if (m_channelCount == 0 || (m_server.hasArg(F("channel")) && !channelArg(index)))
+  {
+    m_server.send(404, "text/plain", F("Alerts not available"));
+    return;
+  }
+  const AlertEventLog &alerts = m_channels[index].alerts;
+
+  m_server.sendHeader(F("Cache-Control"), F("no-store"));
+  m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  m_server.send(200, "application/json", "");
+
+  ChunkedResponse out(m_server);
+  out.appendP(PSTR("{\"channel\":\""));
+  out.append(m_channels[index].config->name);
+  out.appendP(PSTR("\",\"total\":"));
+  out.appendUnsigned(alerts.total());
+  out.appendP(PSTR(",\"active\":\""));
+  bool first = true;
+  forEachAlertFlag(alerts.active(),
+                   [&](const char *name)
+                   {
+                     out.append(first ? "" : "|");
+                     out.append(name);
+                     first = false;
+                   });
+  out.appendP(PSTR("\",\"current\":["));
+  out.appendSigned(ina::CurrentScale::kNum);
+  out.append(",");
+  out.appendSigned(ina::CurrentScale::kExp10);
+  out.appendP(PSTR("],\"vbus\":["));
+  out.appendSigned(ina::BusVoltageScale::kNum);
+  out.append(",");
+  out.appendSigned(ina::BusVoltageScale::kExp10);
+  out.appendP(PSTR("],\"events\":["));
+
+  for (size_t i = 0; i < alerts.count(); ++i)
+  {
+    const AlertEvent &event = alerts.event(i);
+    out.append(i == 0 ? "[" : ",[");
+    out.appendUnsigned(event.timestampUs);
+    out.append(",");
+    out.appendUnsigned(event.timestampMs);
+    out.append(",\"");
+    first = true;
+    forEachAlertFlag(event.flags,
+                     [&](const char *name)
+                     {
+                       out.append(first ? "" : "|");
+                       out.append(name);
+                       first = false;
+                     });
+    out.append("\",");
+    out.appendSigned(event.current);
+    out.append(",");
+    out.appendSigned(event.vBus);
+    out.append("]");
+  }
+
+  out.append("]}");
+  out.finish();
+}
+
+// GET /api/trigger returns the settings, the state and, once captured, the
+// samples [ms, current, vbus] with the trigger at "trigger_index".
+// /api/trigger?arm=1 re-arms; source=current|vbus, edge=rising|falling,
+// level (A or V), pre and post override the current settings.
+void WebInterface::sendTrigger()
+{
+  if (m_trigger == nullptr)
+  {
+    m_server.send(404, "text/plain", F("Trigger not available"));
+    return;
+  }
+
+  m_server.sendHeader(F("Cache-Control"), F("no-store"));
+
+  if (m_server.arg(F("arm")) == "1")
+  {
+    TriggerCapture::Config config = m_trigger->config();
+    if (m_server.hasArg(F("source")))
+    {
+      config.source = (m_server.arg(F("source")) == "vbus") ? TriggerCapture::Source::BusVoltage : TriggerCapture::Source::Current;
+    }
+    if (m_server.hasArg(F("edge")))
+    {
+      config.edge = (m_server.arg(F("edge")) == "falling") ? TriggerCapture::Edge::Falling : TriggerCapture::Edge::Rising;
+    }
+
+    // the level is kept as a raw code of its source, so it can't carry over
+    if (m_server.hasArg(F("level")))
+    {
+      config.level = TriggerCapture::levelCode(config.source, m_server.arg(F("level")).toFloat());
+    }
+    else if (config.source != m_trigger->config().source)
+    {
+      m_server.send(400, "text/plain", F("level is required with a new source"));
+      return;
+    }
+
+    // range-checked before narrowing, so 65600 doesn't wrap to 64
+    auto sampleCount = [&](const __FlashStringHelper *name, uint16_t &count) -> bool
+    {
+      if (!m_server.hasArg(name))
+        return true;
+      const long value = m_server.arg(name).toInt();
+      if (value < 0 || value >= static_cast<long>(TriggerCapture::kCapacity))
+        return false;
+      count = static_cast<uint16_t>(value);
+      return true;
+    };
+    if (!sampleCount(F("pre"), config.preSamples) || !sampleCount(F("post"), config.postSamples))
+    {
+      m_server.send(400, "text/plain", F("pre and post must be below the capture size"));
+      return;
+    }
+
+    if (!m_trigger->arm(config))
+    {
+      m_server.send(400, "text/plain", F("pre + post must stay below the capture size"));
+      return;
+    }
+    m_server.send(202, "application/json", F("{\"state\":\"armed\"}"));
+    return;
+  }
+
+  static const char *const kStateNames[] = { "idle", "armed", "triggered", "captured" };
+
+  const TriggerCapture::Config &config = m_trigger->config();
+  const bool                    frozen = m_trigger->state() == TriggerCapture::State::Captured;
+
+  m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  m_server.send(200, "application/json", "");
+
+  ChunkedResponse out(m_server);
+  out.appendP(PSTR("{\"state\":\""));
+  out.append(kStateNames[static_cast<uint8_t>(m_trigger->state())]);
+  out.appendP(PSTR("\",\"capture\":"));
+  out.appendUnsigned(m_trigger->captureId());
+  out.appendP(PSTR(",\"source\":\""));
+  out.append(config.source == TriggerCapture::Source::Current ? "current" : "vbus");
+  out.appendP(PSTR("\",\"edge\":\""));
+  out.append(config.edge == TriggerCapture::Edge::Rising ? "rising" : "falling");
+  out.appendP(PSTR("\",\"level\":"));
+  out.appendSigned(config.level);
+  out.appendP(PSTR(",\"pre\":"));
+  out.appendUnsigned(config.preSamples);
+  out.appendP(PSTR(",\"post\":"));
+  out.appendUnsigned(config.postSamples);
+  out.appendP(PSTR(",\"trigger_index\":"));
+  out.appendUnsigned(frozen ? m_trigger->triggerIndex() : 0);
+  out.appendP(PSTR(",\"current\":["));
+  out.appendSigned(ina::CurrentScale::kNum);
+  out.append(",");
+  out.appendSigned(ina::CurrentScale::kExp10);
+  out.appendP(PSTR("],\"vbus\":["));
+  out.appendSigned(ina::BusVoltageScale::kNum);
+  out.append(",");
+  out.appendSigned(ina::BusVoltageScale::kExp10);
+  out.appendP(PSTR("],\"samples\":["));
+
+  const size_t count = frozen ? m_trigger->count() : 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const TriggerCapture::Sample &sample = m_trigger->sample(i);
+    out.append(i == 0 ? "[" : ",[");
+    out.appendUnsigned(sample.timestampMs);
+    out.append(",");
+    out.appendSigned(sample.current);
+    out.append(",");
+    out.appendSigned(sample.vBus);
+    out.append("]");
+  }
+
+  out.append("]}");
+  out.finish();
+}
+
+// The persistent one-minute buckets as CSV, read from flash a page at a time
+// while the response is sent. ?since=<sequence> skips older records.
+void WebInterface::sendEnergyLog()
+{
+  if (m_energyLog == nullptr || !m_energyLog->ready())
+  {
+    m_server.send(404, "text/plain", F("Energy log not available"));
+    return;
+  }
+
+  const uint32_t since = strtoul(m_server.arg(F("since")).c_str(), nullptr, 10);
+
+  m_server.sendHeader(F("Cache-Control"), F("no-store"));
+  m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  m_server.send(200, "text/csv", "");
+
+  ChunkedResponse out(m_server);
+  out.appendP(PSTR("# current="));
+  out.appendSigned(ina::CurrentScale::kNum);
+  out.append("e");
+  out.appendSigned(ina::CurrentScale::kExp10);
+  out.appendP(PSTR(" A, energy="));
+  out.appendSigned(ina::EnergyScale::kNum);
+  out.append("e");
+  out.appendSigned(ina::EnergyScale::kExp10);
+  out.appendP(PSTR(" Ws\nsequence,start_s,samples,current_min,current_max,current_mean,energy,energy_total\n"));
+
+  m_energyLog->forEachRecord(since,
+                             [&](const EnergyLog::Record &record)
+                             {
+                               out.appendUnsigned(record.sequence);
+                               out.append(",");
+                               out.appendUnsigned(record.bucket.startSeconds);
+                               out.append(",");
+                               out.appendUnsigned(record.bucket.samples);
+                               out.append(",");
+                               out.appendSigned(record.bucket.minCurrent);
+                               out.append(",");
+                               out.appendSigned(record.bucket.maxCurrent);
+                               out.append(",");
+                               out.appendSigned(record.bucket.meanCurrent);
+                               out.append(",");
+                               out.appendUnsigned(record.bucket.energy);
+                               out.append(",");
+                               out.appendUnsigned(record.totalEnergy);
+                               out.append("\n");
+                               return true;
+                             });
+
+  out.finish();
+}
+
+// Prometheus text exposition: per-stage latency histograms, scheduler task
+// statistics and heap and loop health. Counters start at boot; durations are
+// in seconds as Prometheus expects.
+void WebInterface::sendMetrics()
+{
+  m_server.sendHeader(F("Cache-Control"), F("no-store"));
+  m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  m_server.send(200, "text/plain; version=0.0.4", "");
+
+  ChunkedResponse out(m_server);
+
+  // micros64() doesn't wrap like millis() does after 49.7 days
+  appendMetric(out, PSTR("power_meter_uptime_seconds"), PSTR("gauge"), PSTR("Time since boot."), micros64() / 1000000);
+  appendMetric(out, PSTR("power_meter_heap_free_bytes"), PSTR("gauge"), PSTR("Free heap."), ESP.getFreeHeap());
+  appendMetric(out, PSTR("power_meter_heap_max_block_bytes"), PSTR("gauge"), PSTR("Largest free heap block."),
+               ESP.getMaxFreeBlockSize());
+  appendMetric(out, PSTR("power_meter_heap_fragmentation_percent"), PSTR("gauge"), PSTR("Heap fragmentation."),
+               ESP.getHeapFragmentation());
+
+  if (m_profiler != nullptr)
+  {
+    appendMetricHeader(out, PSTR("power_meter_loop_gap_max_seconds"), PSTR("gauge"),
+                       PSTR("Longest time between two main loop iterations."));
+    out.appendP(PSTR("power_meter_loop_gap_max_seconds "));
+    out.appendSeconds(m_profiler->maxLoopGapUs());
+    out.append("\n");
+
+    appendMetricHeader(out, PSTR("power_meter_stage_duration_seconds"), PSTR("histogram"),
+                       PSTR("Duration of the instrumented main loop stages."));
+    for (size_t i = 0; i < Profiler::kStageCount; ++i)
+    {
+      const ProfileStage stage = static_cast<ProfileStage>(i);
+      appendHistogramSeries(out, PSTR("power_meter_stage_duration_seconds"), PSTR("stage"), Profiler::stageName(stage),
+                            m_profiler->histogram(stage));
+    }
+  }
+
+  if (m_channelCount > 0)
+  {
+    // one labelled sample per channel, like the task families below
+    const auto appendChannels = [&](PGM_P name, PGM_P type, PGM_P help, bool seconds, uint64_t (*value)(const InaChannel &))
+    {
+      appendMetricHeader(out, name, type, help);
+      for (size_t i = 0; i < m_channelCount; ++i)
+      {
+        out.appendP(name);
+        out.appendP(PSTR("{channel=\""));
+        out.append(m_channels[i].config->name);
+        out.append("\"} ");
+        if (seconds)
+          out.appendSeconds(value(m_channels[i]));
+        else
+          out.appendUnsigned(value(m_channels[i]));
+        out.append("\n");
+      }
+    };
+
+    appendChannels(PSTR("power_meter_limit_events_total"), PSTR("counter"), PSTR("INA228 limit violations."), false,
+                   [](const InaChannel &channel) -> uint64_t { return channel.alerts.total(); });
+    appendChannels(PSTR("power_meter_conversion_edges_total"), PSTR("counter"), PSTR("INA228 conversion-ready ALERT edges."),
+                   false, [](const InaChannel &channel) -> uint64_t { return channel.timing.edges(); });
+    appendChannels(PSTR("power_meter_conversions_dropped_total"), PSTR("counter"),
+                   PSTR("Conversions overwritten before they were read."), false,
+                   [](const InaChannel &channel) -> uint64_t { return channel.timing.droppedConversions(); });
+    appendChannels(PSTR("power_meter_alert_stamps_lost_total"), PSTR("counter"),
+                   PSTR("ALERT edges whose timestamp was overwritten before the main loop took it."), false,
+                   [](const InaChannel &channel) -> uint64_t { return channel.timing.lostStamps(); });
+    appendChannels(PSTR("power_meter_sample_interval_seconds"), PSTR("gauge"),
+                   PSTR("Time between the last two conversion edges."), true,
+                   [](const InaChannel &channel) -> uint64_t { return channel.timing.lastIntervalUs(); });
+
+    appendMetricHeader(out, PSTR("power_meter_sample_service_latency_seconds"), PSTR("histogram"),
+                       PSTR("Time from a conversion edge to the register read."));
+    for (size_t i = 0; i < m_channelCount; ++i)
+    {
+      appendHistogramSeries(out, PSTR("power_meter_sample_service_latency_seconds"), PSTR("channel"),
+                            m_channels[i].config->name, m_channels[i].timing.serviceLatency());
+    }
+
+    appendMetricHeader(out, PSTR("power_meter_sample_interval_jitter_seconds"), PSTR("histogram"),
+                       PSTR("Change of the interval between consecutive conversion edges."));
+    for (size_t i = 0; i < m_channelCount; ++i)
+    {
+      appendHistogramSeries(out, PSTR("power_meter_sample_interval_jitter_seconds"), PSTR("channel"),
+                            m_channels[i].config->name, m_channels[i].timing.intervalJitter());
+    }
+  }
+
+  if (m_scheduler != nullptr)
+  {
+    // one labelled sample per task; seconds values are written from microseconds
+    const auto appendTasks = [&](PGM_P name, PGM_P type, PGM_P help, bool seconds, uint64_t (*value)(const Scheduler::TaskStats &))
+    {
+      appendMetricHeader(out, name, type, help);
+      for (uint8_t task = 0; task < m_scheduler->taskCount(); ++task)
+      {
+        out.appendP(name);
+        out.appendP(PSTR("{task=\""));
+        out.append(m_scheduler->config(task).name);
+        out.append("\"} ");
+        if (seconds)
+          out.appendSeconds(value(m_scheduler->stats(task)));
+        else
+          out.appendUnsigned(value(m_scheduler->stats(task)));
+        out.append("\n");
+      }
+    };
+
+    appendTasks(PSTR("power_meter_task_runs_total"), PSTR("counter"), PSTR("Scheduler task executions."), false,
+                [](const Scheduler::TaskStats &stats) -> uint64_t { return stats.runs; });
+    appendTasks(PSTR("power_meter_task_seconds_total"), PSTR("counter"), PSTR("Time spent in the task."), true,
+                [](const Scheduler::TaskStats &stats) -> uint64_t { return stats.totalUs; });
+    appendTasks(PSTR("power_meter_task_max_seconds"), PSTR("gauge"), PSTR("Longest task execution."), true,
+                [](const Scheduler::TaskStats &stats) -> uint64_t { return stats.maxUs; });
+    appendTasks(PSTR("power_meter_task_latency_max_seconds"), PSTR("gauge"), PSTR("Longest wait from due to started."), true,
+                [](const Scheduler::TaskStats &stats) -> uint64_t { return stats.maxLatencyUs; });
+    appendTasks(PSTR("power_meter_task_overruns_total"), PSTR("counter"), PSTR("Executions over the time budget."), false,
+                [](const Scheduler::TaskStats &stats) -> uint64_t { return stats.overruns; });
+    appendTasks(PSTR("power_meter_task_deadline_misses_total"), PSTR("counter"), PSTR("Starts later than the deadline."), false,
+                [](const Scheduler::TaskStats &stats) -> uint64_t { return stats.deadlineMisses; });
+  }
+
+  out.finish();
+}
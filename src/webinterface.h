@@ -4,7 +4,17 @@
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
 
-struct InaValues;
+#include "ina_values.h"
+
+class BurstCapture;
+class EnergyLog;
+class MeasurementHistory;
+class SampleArchive;
+class Profiler;
+class Scheduler;
+class TieredHistory;
+class TriggerCapture;
+struct InaChannel;
 
 class WebInterface
 {
@@ -15,15 +25,59 @@ public:
   IPAddress localIp() const;
   bool isConnected() const;
   void updateMeasurements(const InaValues &values);
+  void attachHistory(const TieredHistory *history);
+  void attachSamples(const MeasurementHistory *samples);
+  void attachArchive(const SampleArchive *archive);
+  void attachBurst(BurstCapture *burst);
+  void attachChannels(const InaChannel *channels, size_t count);
+  void attachTrigger(TriggerCapture *trigger);
+  void attachEnergyLog(const EnergyLog *log);
+  void attachProfiler(Profiler *profiler);
+  void attachScheduler(const Scheduler *scheduler);
   void loop();
 
 private:
-  String buildPage() const;
-
-  ESP8266WebServer m_server;
-  String           m_lastMeasurementHtml;
-  bool             m_webReady;
-  bool             m_connected;
-  IPAddress        m_localIp;
-  float            m_lastEnergyWs;
+  void sendMainPage();
+  void sendHistoryPage();
+  void sendSamples();
+  void sendBurst();
+  void sendAlerts();
+  void sendTrigger();
+  void sendEnergyLog();
+  void sendMetrics();
+  void route(const char *uri, void (WebInterface::*handler)());
+  bool channelArg(size_t &index);
+  void acceptStreamClient();
+  void publishMeasurement();
+
+  static constexpr uint8_t kMaxStreamClients = 4;
+
+  struct StreamClient
+  {
+    WiFiClient client;
+    uint32_t   lastWriteMs = 0;
+    bool       active      = false;
+  };
+
+  ESP8266WebServer         m_server;
+  InaValues                m_lastValues;
+  uint64_t                 m_lastEnergyDelta;
+  uint32_t                 m_sequence; // bumped per total, part of the ETag
+  uint32_t                 m_bootTag;  // random per boot, prefixes the ETag
+  bool                     m_webReady;
+  bool                     m_connected;
+  IPAddress                m_localIp;
+  uint64_t                 m_lastEnergy;
+  bool                     m_hasLastEnergy;
+  const TieredHistory      *m_history;
+  const MeasurementHistory *m_samples;
+  const SampleArchive      *m_archive;
+  BurstCapture             *m_burst;
+  const InaChannel         *m_channels;
+  size_t                    m_channelCount;
+  TriggerCapture           *m_trigger;
+  const EnergyLog          *m_energyLog;
+  Profiler                 *m_profiler;
+  const Scheduler          *m_scheduler;
+  StreamClient              m_streamClients[kMaxStreamClients];
 };
@@ -0,0 +1,83 @@
+#include <unity.h>
+
+#include "alert_events.h"
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_conversion_edge()
+{
+  AlertEventLog   log;
+  const AlertRead read = log.update(ina::kDiagConversionDone, true, 1000, 1100);
+  TEST_ASSERT_TRUE(read.edge);
+  TEST_ASSERT_TRUE(read.converted);
+  TEST_ASSERT_FALSE(read.event);
+}
+
+// A conversion completes between draining the edges and reading DIAG_ALRT:
+// that read takes CNVRF and the result. The edge it raised must not count as
+// a second conversion, nor as a transient, on the next read.
+void test_conversion_read_ahead_of_its_edge()
+{
+  AlertEventLog log;
+  AlertRead     read = log.update(ina::kDiagConversionDone, false, 0, 1000);
+  TEST_ASSERT_TRUE(read.converted);
+  TEST_ASSERT_FALSE(read.event);
+
+  read = log.update(0, true, 990, 1200);
+  TEST_ASSERT_FALSE(read.edge);
+  TEST_ASSERT_FALSE(read.converted);
+  TEST_ASSERT_FALSE(read.event);
+
+  read = log.update(ina::kDiagConversionDone, true, 5000, 5100);
+  TEST_ASSERT_TRUE(read.edge);
+  TEST_ASSERT_TRUE(read.converted);
+  TEST_ASSERT_FALSE(read.event);
+}
+
+void test_transient()
+{
+  AlertEventLog   log;
+  log.update(ina::kDiagConversionDone, true, 1000, 1100);
+  const AlertRead read = log.update(0, true, 2000, 2100);
+  TEST_ASSERT_TRUE(read.edge);
+  TEST_ASSERT_FALSE(read.converted);
+  TEST_ASSERT_TRUE(read.event);
+  TEST_ASSERT_EQUAL_UINT16(0, read.newFlags);
+}
+
+void test_lasting_violation_recorded_once()
+{
+  AlertEventLog log;
+  AlertRead     read = log.update(ina::kDiagShuntOver, true, 1000, 1100);
+  TEST_ASSERT_TRUE(read.event);
+  TEST_ASSERT_EQUAL_UINT16(ina::kDiagShuntOver, read.newFlags);
+
+  read = log.update(ina::kDiagShuntOver | ina::kDiagConversionDone, false, 0, 11000);
+  TEST_ASSERT_TRUE(read.converted);
+  TEST_ASSERT_FALSE(read.event);
+  TEST_ASSERT_EQUAL_UINT16(ina::kDiagShuntOver, log.active());
+
+  read = log.update(ina::kDiagShuntOver | ina::kDiagPowerOver, false, 0, 21000);
+  TEST_ASSERT_TRUE(read.event);
+  TEST_ASSERT_EQUAL_UINT16(ina::kDiagPowerOver, read.newFlags);
+
+  read = log.update(0, false, 0, 31000);
+  TEST_ASSERT_FALSE(read.event);
+  TEST_ASSERT_EQUAL_UINT16(0, log.active());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_conversion_edge);
+  RUN_TEST(test_conversion_read_ahead_of_its_edge);
+  RUN_TEST(test_transient);
+  RUN_TEST(test_lasting_violation_recorded_once);
+  return UNITY_END();
+}
@@ -0,0 +1,151 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "compressed_history.h"
+
+namespace
+{
+  // four small blocks, so eviction comes often
+  using Archive = CompressedHistory<64, 4>;
+
+  uint32_t randomState = 0x9E3779B9;
+
+  uint32_t nextRandom()
+  {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+  }
+
+  struct Reference
+  {
+    std::vector<Archive::Sample> samples; // every sample ever added
+
+    void add(Archive &archive, uint32_t timestampMs, int32_t current, uint64_t energy, int32_t vBus)
+    {
+      InaValues values = {};
+      values.current   = current;
+      values.energy    = energy;
+      values.vBus      = vBus;
+      archive.add(values, timestampMs);
+      samples.push_back({ timestampMs, current, energy, vBus });
+    }
+  };
+
+  // forEachSince(since) yields exactly the retained tail of the reference
+  void checkSince(const Archive &archive, const Reference &reference, uint32_t since)
+  {
+    const uint32_t first    = archive.nextSequence() - static_cast<uint32_t>(archive.countSince(since));
+    uint32_t       expected = first;
+    archive.forEachSince(since,
+                         [&](uint32_t seq, const Archive::Sample &sample)
+                         {
+                           TEST_ASSERT_EQUAL_UINT32(expected, seq);
+                           const Archive::Sample &want = reference.samples[seq];
+                           TEST_ASSERT_EQUAL_UINT32(want.timestampMs, sample.timestampMs);
+                           TEST_ASSERT_EQUAL_INT32(want.current, sample.current);
+                           TEST_ASSERT_EQUAL_UINT64(want.energy, sample.energy);
+                           TEST_ASSERT_EQUAL_INT32(want.vBus, sample.vBus);
+                           ++expected;
+                         });
+    TEST_ASSERT_EQUAL_UINT32(archive.nextSequence(), expected);
+  }
+
+  void checkAll(const Archive &archive, const Reference &reference)
+  {
+    TEST_ASSERT_EQUAL_UINT32(reference.samples.size(), archive.nextSequence());
+    TEST_ASSERT_TRUE(archive.count() > 0);
+    checkSince(archive, reference, archive.firstSequence());
+  }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// noise on every channel, with the odd time jump and energy reset
+void test_round_trip()
+{
+  Archive   archive;
+  Reference reference;
+  uint32_t  timestampMs = 1000;
+  uint64_t  energy      = 0;
+  for (uint32_t i = 0; i < 3000; ++i)
+  {
+    const uint32_t event = nextRandom() % 100;
+    if (event == 0)
+      timestampMs += 3600000; // long gap
+    else if (event == 1)
+      timestampMs -= 500; // clock stepped back
+    else
+      timestampMs += 100 + nextRandom() % 5;
+
+    energy = (event == 2) ? 0 : energy + nextRandom() % 1000; // accumulator reset
+
+    const int32_t current = static_cast<int32_t>(nextRandom() % 2000000) - 1000000;
+    const int32_t vBus    = (event == 3) ? -1 : static_cast<int32_t>(nextRandom() % 30000);
+    reference.add(archive, timestampMs, current, energy, vBus);
+    checkAll(archive, reference);
+  }
+}
+
+// a steady signal packs small, but blocks still drop out whole at the front
+void test_block_eviction()
+{
+  Archive   archive;
+  Reference reference;
+  size_t    previousCount = 0;
+  bool      evicted       = false;
+  for (uint32_t i = 0; i < 500; ++i)
+  {
+    reference.add(archive, i * 100, 320000, i * 50ULL, 16000);
+    evicted       = evicted || archive.count() < previousCount;
+    previousCount = archive.count();
+    TEST_ASSERT_EQUAL_UINT32(archive.nextSequence() - archive.count(), archive.firstSequence());
+  }
+  TEST_ASSERT_TRUE(evicted);
+  TEST_ASSERT_TRUE(archive.count() < 500);
+  TEST_ASSERT_TRUE(archive.packedBytes() < archive.count() * sizeof(Archive::Sample));
+  checkAll(archive, reference);
+}
+
+void test_cursors()
+{
+  Archive   archive;
+  Reference reference;
+  for (uint32_t i = 0; i < 400; ++i)
+    reference.add(archive, i * 100, static_cast<int32_t>(i), i, 100);
+  TEST_ASSERT_TRUE(archive.firstSequence() > 0);
+
+  // before the retained range: everything that is left
+  TEST_ASSERT_EQUAL_size_t(archive.count(), archive.countSince(0));
+  TEST_ASSERT_EQUAL_size_t(archive.count(), archive.countSince(archive.firstSequence() - 1));
+  checkSince(archive, reference, 0);
+  checkSince(archive, reference, archive.firstSequence() - 1);
+
+  // inside the range and at its ends
+  checkSince(archive, reference, archive.firstSequence() + 1);
+  checkSince(archive, reference, archive.nextSequence() - 1);
+  TEST_ASSERT_EQUAL_size_t(1, archive.countSince(archive.nextSequence() - 1));
+  TEST_ASSERT_EQUAL_size_t(0, archive.countSince(archive.nextSequence()));
+  checkSince(archive, reference, archive.nextSequence());
+
+  // ahead of the archive, e.g. from before a reboot: everything
+  TEST_ASSERT_EQUAL_size_t(archive.count(), archive.countSince(archive.nextSequence() + 10));
+  checkSince(archive, reference, archive.nextSequence() + 10);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_block_eviction);
+  RUN_TEST(test_cursors);
+  return UNITY_END();
+}
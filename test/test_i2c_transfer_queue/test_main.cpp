@@ -0,0 +1,147 @@
+#include <unity.h>
+
+#include <string>
+
+#include "i2c_transfer_queue.h"
+
+namespace
+{
+  using Priority = I2cTransferQueue::Priority;
+
+  std::string trace; // step names, '!' per completion
+
+  struct Job
+  {
+    char name;
+    int  steps;
+    bool done;
+  };
+
+  bool step(void *context)
+  {
+    Job &job = *static_cast<Job *>(context);
+    trace += job.name;
+    return --job.steps == 0;
+  }
+
+  void done(void *context)
+  {
+    static_cast<Job *>(context)->done = true;
+    trace += '!';
+  }
+
+  I2cTransferQueue *resubmitQueue = nullptr;
+  Job               resubmitted   = { 'r', 1, false };
+
+  // completion that queues a follow-up transfer into the slot just freed
+  void doneAndResubmit(void *context)
+  {
+    done(context);
+    TEST_ASSERT_TRUE(resubmitQueue->submit(Priority::Normal, step, done, &resubmitted));
+  }
+}
+
+void setUp()
+{
+  trace.clear();
+}
+
+void tearDown()
+{
+}
+
+void test_empty_queue()
+{
+  I2cTransferQueue queue;
+  TEST_ASSERT_FALSE(queue.pending());
+  TEST_ASSERT_FALSE(queue.runStep());
+}
+
+// A higher priority transfer goes ahead after the step in progress; within a
+// priority the transfers run in submission order.
+void test_priority_and_fifo()
+{
+  I2cTransferQueue queue;
+  Job              a = { 'a', 3, false };
+  Job              b = { 'b', 2, false };
+  Job              h = { 'h', 1, false };
+  TEST_ASSERT_TRUE(queue.submit(Priority::Low, step, done, &a));
+  TEST_ASSERT_TRUE(queue.submit(Priority::Low, step, done, &b));
+  TEST_ASSERT_TRUE(queue.runStep());
+  TEST_ASSERT_TRUE(queue.submit(Priority::High, step, done, &h));
+  while (queue.runStep())
+  {
+  }
+
+  TEST_ASSERT_EQUAL_STRING("ah!aa!bb!", trace.c_str());
+  TEST_ASSERT_TRUE(a.done && b.done && h.done);
+  TEST_ASSERT_FALSE(queue.pending());
+}
+
+// FIFO holds across reused slots: a later submission in a lower slot still
+// runs after the older transfer.
+void test_fifo_across_slots()
+{
+  I2cTransferQueue queue;
+  Job              first  = { '1', 1, false };
+  Job              second = { '2', 2, false };
+  Job              third  = { '3', 1, false };
+  queue.submit(Priority::Normal, step, done, &first);
+  queue.submit(Priority::Normal, step, done, &second);
+  queue.runStep(); // frees slot 0
+  queue.submit(Priority::Normal, step, done, &third);
+  while (queue.runStep())
+  {
+  }
+
+  TEST_ASSERT_EQUAL_STRING("1!22!3!", trace.c_str());
+}
+
+void test_completion_may_submit()
+{
+  I2cTransferQueue queue;
+  Job              waiting = { 'w', 100, false };
+  Job              job     = { 'j', 1, false };
+  resubmitQueue            = &queue;
+  for (size_t i = 0; i < I2cTransferQueue::kCapacity - 1; ++i)
+  {
+    TEST_ASSERT_TRUE(queue.submit(Priority::Low, step, nullptr, &waiting));
+  }
+  TEST_ASSERT_TRUE(queue.submit(Priority::High, step, doneAndResubmit, &job));
+
+  TEST_ASSERT_TRUE(queue.runStep());
+  TEST_ASSERT_TRUE(job.done);
+  TEST_ASSERT_TRUE(queue.pending());
+  TEST_ASSERT_EQUAL_STRING("j!", trace.c_str());
+
+  // the follow-up outranks the waiting low priority transfers
+  TEST_ASSERT_TRUE(queue.runStep());
+  TEST_ASSERT_TRUE(resubmitted.done);
+  TEST_ASSERT_EQUAL_STRING("j!r!", trace.c_str());
+}
+
+void test_full_queue()
+{
+  I2cTransferQueue queue;
+  Job              job = { 'x', 1, false };
+  for (size_t i = 0; i < I2cTransferQueue::kCapacity; ++i)
+  {
+    TEST_ASSERT_TRUE(queue.submit(Priority::Normal, step, nullptr, &job));
+  }
+  TEST_ASSERT_FALSE(queue.submit(Priority::High, step, nullptr, &job));
+
+  // a transfer without completion callback frees its slot all the same
+  TEST_ASSERT_TRUE(queue.runStep());
+  TEST_ASSERT_TRUE(queue.submit(Priority::High, step, nullptr, &job));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_queue);
+  RUN_TEST(test_priority_and_fifo);
+  RUN_TEST(test_fifo_across_slots);
+  RUN_TEST(test_completion_may_submit);
+  RUN_TEST(test_full_queue);
+  return UNITY_END();
+}
@@ -0,0 +1,153 @@
+#include <unity.h>
+
+#include "measurement_history.h"
+
+namespace
+{
+  using History = BasicMeasurementHistory<8>;
+
+  // Feeds `values` and checks the window min/max against a full scan after
+  // every sample.
+  void checkAgainstScan(const int32_t *values, size_t count)
+  {
+    History history;
+    for (size_t i = 0; i < count; ++i)
+    {
+      history.addMeasurement(values[i], 0, i);
+
+      const size_t first = (i + 1 > History::kCapacity) ? i + 1 - History::kCapacity : 0;
+      int32_t      lo    = values[first];
+      int32_t      hi    = values[first];
+      for (size_t j = first; j <= i; ++j)
+      {
+        lo = (values[j] < lo) ? values[j] : lo;
+        hi = (values[j] > hi) ? values[j] : hi;
+      }
+
+      const History::CurrentStats stats = history.getCurrentStats();
+      TEST_ASSERT_EQUAL_INT32(lo, stats.minCurrent);
+      TEST_ASSERT_EQUAL_INT32(hi, stats.maxCurrent);
+    }
+  }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// A rising ramp keeps every sample in the max queue: once the window is full,
+// the queue holds kCapacity entries when the next one arrives.
+void test_ramp_up()
+{
+  int32_t values[40];
+  for (size_t i = 0; i < 40; ++i)
+    values[i] = static_cast<int32_t>(i) * 10 - 100;
+  checkAgainstScan(values, 40);
+}
+
+void test_ramp_down()
+{
+  int32_t values[40];
+  for (size_t i = 0; i < 40; ++i)
+    values[i] = 100 - static_cast<int32_t>(i) * 10;
+  checkAgainstScan(values, 40);
+}
+
+void test_ramp_up_then_down()
+{
+  int32_t values[64];
+  for (size_t i = 0; i < 64; ++i)
+    values[i] = (i < 32) ? static_cast<int32_t>(i) : static_cast<int32_t>(64 - i);
+  checkAgainstScan(values, 64);
+}
+
+void test_pseudo_random()
+{
+  int32_t  values[500];
+  uint32_t state = 12345;
+  for (size_t i = 0; i < 500; ++i)
+  {
+    state     = state * 1103515245u + 12345u;
+    values[i] = static_cast<int32_t>(state >> 12) - (1 << 19);
+  }
+  checkAgainstScan(values, 500);
+}
+
+// The extra channels are stored in rings of their own; after the ring wraps
+// every index of channel<>() must still belong to the same sample as
+// currents() and timestamps().
+void test_channels_after_wrap()
+{
+  BasicMeasurementHistory<8, history::BusVoltage, history::DieTemp, history::BusVoltageCoarse> history;
+  for (int32_t i = 0; i < 21; ++i)
+  {
+    InaValues values = {};
+    values.current   = i;
+    values.energy    = static_cast<uint64_t>(i) * 3;
+    values.vBus      = 1000 + i * 16;
+    values.dieTemp   = static_cast<int16_t>(-i);
+    history.addMeasurement(values, static_cast<uint32_t>(i) * 10);
+
+    const RingView<int32_t>  currents = history.currents();
+    const RingView<uint64_t> energy   = history.energy();
+    const RingView<uint32_t> times    = history.timestamps();
+    const RingView<int32_t>  vBus     = history.channel<history::BusVoltage>();
+    const RingView<int16_t>  dieTemp  = history.channel<history::DieTemp>();
+    const RingView<uint16_t> coarse   = history.channel<history::BusVoltageCoarse>();
+
+    TEST_ASSERT_EQUAL_size_t(history.count(), vBus.size());
+    TEST_ASSERT_EQUAL_size_t(history.count(), dieTemp.size());
+    TEST_ASSERT_EQUAL_INT32(i, currents[currents.size() - 1]);
+    for (size_t j = 0; j < currents.size(); ++j)
+    {
+      const int32_t sample = currents[j];
+      TEST_ASSERT_EQUAL_UINT64(static_cast<uint64_t>(sample) * 3, energy[j]);
+      TEST_ASSERT_EQUAL_UINT32(static_cast<uint32_t>(sample) * 10, times[j]);
+      TEST_ASSERT_EQUAL_INT32(1000 + sample * 16, vBus[j]);
+      TEST_ASSERT_EQUAL_INT32(-sample, dieTemp[j]);
+      TEST_ASSERT_EQUAL_UINT16((1000 + sample * 16) >> 4, coarse[j]);
+    }
+  }
+}
+
+void test_cursors()
+{
+  History history;
+  for (uint32_t i = 0; i < 20; ++i)
+    history.addMeasurement(static_cast<int32_t>(i), i, i);
+  TEST_ASSERT_EQUAL_UINT32(12, history.firstSequence());
+
+  // the sequence number of each visited sample is the value it was given
+  auto check = [&](uint32_t since, uint32_t first)
+  {
+    uint32_t expected = first;
+    history.forEachSince(since,
+                         [&](uint32_t seq, int32_t current, uint64_t, uint32_t)
+                         {
+                           TEST_ASSERT_EQUAL_UINT32(expected, seq);
+                           TEST_ASSERT_EQUAL_INT32(seq, current);
+                           ++expected;
+                         });
+    TEST_ASSERT_EQUAL_UINT32(20, expected);
+  };
+  check(0, 12);  // before the ring
+  check(15, 15); // inside
+  check(20, 20); // up to date
+  check(25, 12); // ahead, from before a reboot
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_ramp_up);
+  RUN_TEST(test_ramp_down);
+  RUN_TEST(test_ramp_up_then_down);
+  RUN_TEST(test_pseudo_random);
+  RUN_TEST(test_channels_after_wrap);
+  RUN_TEST(test_cursors);
+  return UNITY_END();
+}
@@ -0,0 +1,73 @@
+#include <unity.h>
+
+#include "sample_timing.h"
+
+namespace
+{
+  uint32_t drainInto(EdgeTimestampRing<8> &ring, SampleTiming &timing)
+  {
+    return ring.drain([&](uint32_t lost) { timing.addLostStamps(lost); },
+                      [&](uint32_t timestampUs) { timing.addEdge(timestampUs); });
+  }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_edges_in_time()
+{
+  EdgeTimestampRing<8> ring;
+  SampleTiming         timing;
+  for (uint32_t i = 0; i < 3; ++i)
+    ring.push(1000 * i);
+
+  TEST_ASSERT_EQUAL_UINT32(3, drainInto(ring, timing));
+  TEST_ASSERT_FALSE(ring.pending());
+  TEST_ASSERT_EQUAL_UINT32(3, timing.edges());
+  TEST_ASSERT_EQUAL_UINT32(0, timing.lostStamps());
+  TEST_ASSERT_EQUAL_UINT32(1000, timing.lastIntervalUs());
+  TEST_ASSERT_EQUAL_UINT32(1, timing.intervalJitter().count());
+}
+
+// The overwritten stamps sit between the last drained one and the first
+// retained one, so no interval may be taken across them.
+void test_overrun_restarts_intervals()
+{
+  EdgeTimestampRing<8> ring;
+  SampleTiming         timing;
+  for (uint32_t i = 0; i < 3; ++i)
+    ring.push(1000 * i);
+  drainInto(ring, timing);
+
+  for (uint32_t i = 0; i < 11; ++i)
+    ring.push(100000 + 1000 * i);
+
+  TEST_ASSERT_EQUAL_UINT32(11, drainInto(ring, timing));
+  TEST_ASSERT_EQUAL_UINT32(3, timing.lostStamps());
+  TEST_ASSERT_EQUAL_UINT32(14, timing.edges());
+  TEST_ASSERT_EQUAL_UINT32(1000, timing.lastIntervalUs());
+  TEST_ASSERT_EQUAL_UINT32(1 + 6, timing.intervalJitter().count());
+  TEST_ASSERT_EQUAL_UINT32(0, timing.intervalJitter().maxUs());
+}
+
+void test_discard()
+{
+  EdgeTimestampRing<8> ring;
+  ring.push(1);
+  ring.discard();
+  TEST_ASSERT_FALSE(ring.pending());
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_edges_in_time);
+  RUN_TEST(test_overrun_restarts_intervals);
+  RUN_TEST(test_discard);
+  return UNITY_END();
+}
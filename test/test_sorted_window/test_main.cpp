@@ -0,0 +1,149 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "sorted_window.h"
+
+namespace
+{
+  constexpr size_t kWindow = 32;
+
+  uint32_t randomState = 0x2545F491;
+
+  uint32_t nextRandom()
+  {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+  }
+
+  // small range, so duplicates and equal old/new values are common
+  int32_t randomValue()
+  {
+    return static_cast<int32_t>(nextRandom() % 41) - 20;
+  }
+
+  void checkSorted(const SortedWindow<int32_t, kWindow> &window, std::vector<int32_t> values)
+  {
+    std::sort(values.begin(), values.end());
+    TEST_ASSERT_EQUAL_size_t(values.size(), window.size());
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+      TEST_ASSERT_EQUAL_INT32(values[i], window.at(i));
+    }
+  }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_insert_and_erase()
+{
+  SortedWindow<int32_t, kWindow> window;
+  std::vector<int32_t>           values;
+  for (size_t i = 0; i < kWindow; ++i)
+  {
+    values.push_back(randomValue());
+    TEST_ASSERT_TRUE(window.insert(values.back()));
+    checkSorted(window, values);
+  }
+  TEST_ASSERT_FALSE(window.insert(0));
+
+  TEST_ASSERT_FALSE(window.erase(1000));
+  while (!values.empty())
+  {
+    const size_t index = nextRandom() % values.size();
+    TEST_ASSERT_TRUE(window.erase(values[index]));
+    values.erase(values.begin() + static_cast<std::ptrdiff_t>(index));
+    checkSorted(window, values);
+  }
+}
+
+// a sliding window as the histories use it: the oldest value is replaced by
+// the newest one
+void test_random_replace()
+{
+  SortedWindow<int32_t, kWindow> window;
+  std::vector<int32_t>           ring;
+  for (size_t i = 0; i < kWindow; ++i)
+  {
+    ring.push_back(randomValue());
+    window.insert(ring.back());
+  }
+
+  for (size_t i = 0; i < 20000; ++i)
+  {
+    const size_t  slot     = i % kWindow;
+    const int32_t newValue = randomValue();
+    window.replace(ring[slot], newValue);
+    ring[slot] = newValue;
+    checkSorted(window, ring);
+  }
+}
+
+// replacing a value that is not stored falls back to insert()
+void test_replace_missing_value()
+{
+  SortedWindow<int32_t, kWindow> window;
+  window.insert(1);
+  window.insert(3);
+  window.replace(2, 5);
+  checkSorted(window, { 1, 3, 5 });
+}
+
+void test_quantile_with()
+{
+  SortedWindow<int32_t, kWindow> window;
+  std::vector<int32_t>           values;
+  for (size_t size = 0; size < kWindow; ++size)
+  {
+    for (size_t trial = 0; trial < 50; ++trial)
+    {
+      const int32_t        extra    = randomValue();
+      std::vector<int32_t> combined = values;
+      combined.push_back(extra);
+      std::sort(combined.begin(), combined.end());
+
+      for (float q = 0.0f; q <= 1.0f; q += 0.05f)
+      {
+        TEST_ASSERT_EQUAL_INT32(combined[quantileRank(q, combined.size())], window.quantileWith(extra, q));
+      }
+    }
+
+    values.push_back(randomValue());
+    window.insert(values.back());
+
+    std::vector<int32_t> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    for (float q = 0.0f; q <= 1.0f; q += 0.05f)
+    {
+      TEST_ASSERT_EQUAL_INT32(sorted[quantileRank(q, sorted.size())], window.quantile(q));
+    }
+  }
+}
+
+void test_quantile_rank()
+{
+  TEST_ASSERT_EQUAL_size_t(0, quantileRank(0.5f, 0));
+  TEST_ASSERT_EQUAL_size_t(0, quantileRank(-1.0f, 10));
+  TEST_ASSERT_EQUAL_size_t(9, quantileRank(2.0f, 10));
+  TEST_ASSERT_EQUAL_size_t(5, quantileRank(0.5f, 11));
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_insert_and_erase);
+  RUN_TEST(test_random_replace);
+  RUN_TEST(test_replace_missing_value);
+  RUN_TEST(test_quantile_with);
+  RUN_TEST(test_quantile_rank);
+  return UNITY_END();
+}
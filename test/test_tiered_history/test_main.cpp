@@ -0,0 +1,104 @@
+#include <unity.h>
+
+#include <vector>
+
+#include "tiered_history.h"
+
+namespace
+{
+  // The part of EnergyLog that main.cpp relies on: the appended buckets and
+  // the lifetime total, replayed at boot.
+  struct FlashLog
+  {
+    std::vector<HistoryBucket> records;
+    uint64_t                   totalEnergy = 0;
+  };
+
+  // One boot: restore, then `seconds` of live samples of 10 energy counts
+  // each, every closed bucket appended the way logClosedBuckets() does. The
+  // last sample carries no energy and only closes the last whole minute, as
+  // the open bucket is lost at power-off.
+  uint64_t boot(FlashLog &log, uint32_t seconds)
+  {
+    TieredHistory history;
+    uint64_t      total  = 0;
+    uint32_t      resume = 0;
+    for (const HistoryBucket &bucket : log.records)
+    {
+      history.addBucket(bucket);
+      total  += bucket.energy;
+      resume  = bucket.startSeconds + TieredHistory::spec(HistoryTier::Hour).bucketSeconds;
+    }
+    uint32_t logged = history.closedCount(HistoryTier::Hour);
+
+    // lifetime as shown before the first live sample
+    TEST_ASSERT_EQUAL_UINT64(log.totalEnergy, total + history.openBucket(HistoryTier::Hour).energy);
+
+    for (uint32_t i = 0; i <= seconds; ++i)
+    {
+      history.addSample(100, (i < seconds) ? 10 : 0, resume + i);
+
+      const uint32_t                closed  = history.closedCount(HistoryTier::Hour);
+      const RingView<HistoryBucket> buckets = history.buckets(HistoryTier::Hour);
+      for (; logged != closed; ++logged)
+      {
+        const HistoryBucket &bucket = buckets[buckets.size() - (closed - logged)];
+        log.records.push_back(bucket);
+        log.totalEnergy += bucket.energy;
+      }
+    }
+    return log.totalEnergy + history.openBucket(HistoryTier::Hour).energy;
+  }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// The last restored bucket must not be appended again by the first live
+// sample, or the lifetime total grows by a bucket per reboot.
+void test_restart_and_append()
+{
+  FlashLog log;
+  TEST_ASSERT_EQUAL_UINT64(6000, boot(log, 600));
+  TEST_ASSERT_EQUAL_UINT64(12000, boot(log, 600));
+  TEST_ASSERT_EQUAL_UINT64(18000, boot(log, 600));
+
+  for (size_t i = 1; i < log.records.size(); ++i)
+  {
+    TEST_ASSERT_TRUE(log.records[i].startSeconds > log.records[i - 1].startSeconds);
+  }
+}
+
+void test_replayed_bucket_is_closed()
+{
+  TieredHistory history;
+  HistoryBucket bucket = {};
+  bucket.startSeconds  = 120;
+  bucket.samples       = 60;
+  bucket.energy        = 600;
+  bucket.minCurrent    = 5;
+  bucket.maxCurrent    = 50;
+  bucket.meanCurrent   = 20;
+  history.addBucket(bucket);
+
+  TEST_ASSERT_EQUAL_UINT32(1, history.closedCount(HistoryTier::Hour));
+  TEST_ASSERT_EQUAL_UINT32(0, history.openBucket(HistoryTier::Hour).samples);
+  TEST_ASSERT_EQUAL_UINT64(600, history.buckets(HistoryTier::Hour)[0].energy);
+  TEST_ASSERT_EQUAL_INT32(20, history.buckets(HistoryTier::Hour)[0].meanCurrent);
+
+  // the coarser tiers keep it in their open bucket
+  TEST_ASSERT_EQUAL_UINT64(600, history.openBucket(HistoryTier::Day).energy);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_restart_and_append);
+  RUN_TEST(test_replayed_bucket_is_closed);
+  return UNITY_END();
+}
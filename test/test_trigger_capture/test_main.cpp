@@ -0,0 +1,174 @@
+#include <unity.h>
+
+#include "trigger_capture.h"
+
+namespace
+{
+  TriggerCapture::Config currentConfig(TriggerCapture::Edge edge, int32_t level, uint16_t pre, uint16_t post)
+  {
+    TriggerCapture::Config config;
+    config.source      = TriggerCapture::Source::Current;
+    config.edge        = edge;
+    config.level       = level;
+    config.preSamples  = pre;
+    config.postSamples = post;
+    return config;
+  }
+
+  void push(TriggerCapture &trigger, uint32_t timestampMs, int32_t current)
+  {
+    trigger.push({ timestampMs, current, 0 });
+  }
+
+  // the capture is contiguous in time and the trigger sample is the crossing
+  void checkCapture(const TriggerCapture &trigger, uint32_t triggerMs, size_t pre, size_t post)
+  {
+    TEST_ASSERT_TRUE(trigger.state() == TriggerCapture::State::Captured);
+    TEST_ASSERT_EQUAL_size_t(pre + 1 + post, trigger.count());
+    TEST_ASSERT_EQUAL_size_t(pre, trigger.triggerIndex());
+    for (size_t i = 0; i < trigger.count(); ++i)
+    {
+      TEST_ASSERT_EQUAL_UINT32(triggerMs - pre + i, trigger.sample(i).timestampMs);
+    }
+  }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// many samples before the crossing: the pre-trigger samples wrap the ring
+void test_rising_edge_after_wrap()
+{
+  TriggerCapture trigger;
+  TEST_ASSERT_TRUE(trigger.arm(currentConfig(TriggerCapture::Edge::Rising, 100, 32, 64)));
+
+  uint32_t t = 0;
+  for (; t < 1000; ++t)
+    push(trigger, t, 50);
+  push(trigger, t, 150);
+  TEST_ASSERT_TRUE(trigger.state() == TriggerCapture::State::Triggered);
+  const uint32_t triggerMs = t++;
+  for (uint32_t i = 0; i < 64; ++i, ++t)
+    push(trigger, t, 150);
+
+  checkCapture(trigger, triggerMs, 32, 64);
+  TEST_ASSERT_EQUAL_INT32(150, trigger.sample(32).current);
+  TEST_ASSERT_EQUAL_INT32(50, trigger.sample(31).current);
+  TEST_ASSERT_EQUAL_UINT32(1, trigger.captureId());
+
+  // frozen: later samples don't touch the capture
+  push(trigger, t, 0);
+  checkCapture(trigger, triggerMs, 32, 64);
+}
+
+void test_falling_edge()
+{
+  TriggerCapture trigger;
+  TEST_ASSERT_TRUE(trigger.arm(currentConfig(TriggerCapture::Edge::Falling, 100, 4, 4)));
+
+  push(trigger, 0, 50); // below the level, but not a crossing
+  for (uint32_t t = 1; t < 10; ++t)
+    push(trigger, t, 150);
+  TEST_ASSERT_TRUE(trigger.state() == TriggerCapture::State::Armed);
+
+  push(trigger, 10, 100);
+  for (uint32_t t = 11; t < 15; ++t)
+    push(trigger, t, 50);
+
+  checkCapture(trigger, 10, 4, 4);
+}
+
+void test_capacity_limit()
+{
+  TriggerCapture trigger;
+  const size_t   room = TriggerCapture::kCapacity - 1;
+  TEST_ASSERT_FALSE(trigger.arm(currentConfig(TriggerCapture::Edge::Rising, 100, room / 2 + 1, room - room / 2)));
+  TEST_ASSERT_TRUE(trigger.state() == TriggerCapture::State::Idle);
+  TEST_ASSERT_TRUE(trigger.arm(currentConfig(TriggerCapture::Edge::Rising, 100, room / 2, room - room / 2)));
+
+  uint32_t t = 0;
+  for (; t < 300; ++t)
+    push(trigger, t, 0);
+  const uint32_t triggerMs = t;
+  for (uint32_t i = 0; i <= room - room / 2; ++i, ++t)
+    push(trigger, t, 200);
+
+  checkCapture(trigger, triggerMs, room / 2, room - room / 2);
+  TEST_ASSERT_EQUAL_size_t(TriggerCapture::kCapacity, trigger.count());
+}
+
+// The first sample after arm() has nothing to cross from; the second one can
+// trigger, with a single pre-trigger sample.
+void test_trigger_right_after_arm()
+{
+  TriggerCapture trigger;
+  TEST_ASSERT_TRUE(trigger.arm(currentConfig(TriggerCapture::Edge::Rising, 100, 32, 2)));
+  push(trigger, 0, 200);
+  TEST_ASSERT_TRUE(trigger.state() == TriggerCapture::State::Armed);
+
+  trigger.arm(currentConfig(TriggerCapture::Edge::Rising, 100, 32, 2));
+  push(trigger, 0, 50);
+  push(trigger, 1, 200);
+  push(trigger, 2, 200);
+  push(trigger, 3, 200);
+  checkCapture(trigger, 1, 1, 2);
+}
+
+// Re-arming forgets the last sample of the previous capture.
+void test_rearm_needs_a_new_crossing()
+{
+  TriggerCapture trigger;
+  trigger.arm(currentConfig(TriggerCapture::Edge::Rising, 100, 1, 0));
+  push(trigger, 0, 50);
+  push(trigger, 1, 200);
+  TEST_ASSERT_TRUE(trigger.state() == TriggerCapture::State::Captured);
+
+  trigger.arm(currentConfig(TriggerCapture::Edge::Rising, 100, 1, 0));
+  push(trigger, 2, 200);
+  TEST_ASSERT_TRUE(trigger.state() == TriggerCapture::State::Armed);
+}
+
+void test_no_post_samples()
+{
+  TriggerCapture trigger;
+  TEST_ASSERT_TRUE(trigger.arm(currentConfig(TriggerCapture::Edge::Rising, 100, 8, 0)));
+  for (uint32_t t = 0; t < 20; ++t)
+    push(trigger, t, 0);
+  push(trigger, 20, 100);
+
+  checkCapture(trigger, 20, 8, 0);
+  TEST_ASSERT_EQUAL_INT32(100, trigger.sample(trigger.triggerIndex()).current);
+}
+
+void test_bus_voltage_source()
+{
+  TriggerCapture         trigger;
+  TriggerCapture::Config config = currentConfig(TriggerCapture::Edge::Rising, 1000, 2, 1);
+  config.source                 = TriggerCapture::Source::BusVoltage;
+  trigger.arm(config);
+
+  trigger.push({ 0, 5000, 500 });
+  trigger.push({ 1, 5000, 500 });
+  TEST_ASSERT_TRUE(trigger.state() == TriggerCapture::State::Armed);
+  trigger.push({ 2, 0, 1500 });
+  trigger.push({ 3, 0, 1500 });
+  checkCapture(trigger, 2, 2, 1);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_rising_edge_after_wrap);
+  RUN_TEST(test_falling_edge);
+  RUN_TEST(test_capacity_limit);
+  RUN_TEST(test_trigger_right_after_arm);
+  RUN_TEST(test_rearm_needs_a_new_crossing);
+  RUN_TEST(test_no_post_samples);
+  RUN_TEST(test_bus_voltage_source);
+  return UNITY_END();
+}
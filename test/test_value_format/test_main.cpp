@@ -0,0 +1,231 @@
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "value_format.h"
+
+// The snprintf-based formatters that value_format.cpp replaced, kept as the
+// reference for its output.
+namespace reference
+{
+  void formatValue(char *buffer, size_t size, float baseValue, const char *baseUnit, uint8_t digits)
+  {
+    digits = (digits < 4) ? 4 : (digits > 10) ? 10 : digits;
+
+    const ValuePrefix prefix = findValuePrefix(baseValue);
+
+    const float scaled    = baseValue / prefix.factor;
+    const float absScaled = fabsf(scaled);
+
+    uint8_t decimals;
+    if      (absScaled >= 100.0f) decimals = digits - 3;
+    else if (absScaled >= 10.0f)  decimals = digits - 2;
+    else                          decimals = digits - 1;
+
+    if (baseUnit != nullptr && baseUnit[0] != '\0')
+    {
+      char unit[4] = { 0 };
+      snprintf(unit, sizeof(unit), "%s%s", prefix.symbol, baseUnit);
+
+      size_t len = strlen(unit);
+      while (len < 3 && len < sizeof(unit) - 1)
+      {
+        unit[len]     = ' ';
+        unit[len + 1] = '\0';
+        ++len;
+      }
+
+      snprintf(buffer, size, "%.*f %s", decimals, scaled, unit);
+    }
+    else
+    {
+      snprintf(buffer, size, "%.*f", decimals, scaled);
+    }
+  }
+
+  void formatTime(char *buffer, size_t size, float seconds)
+  {
+    unsigned long totalSeconds = static_cast<unsigned long>(seconds + 0.5f);
+    unsigned int  hours        = totalSeconds / 3600;
+    unsigned int  minutes      = (totalSeconds % 3600) / 60;
+    unsigned int  secs         = totalSeconds % 60;
+
+    if (hours > 99)
+    {
+      unsigned int days = totalSeconds / 86400;
+      hours             = (totalSeconds % 86400) / 3600;
+
+      if (days > 99)
+      {
+        days    = 99;
+        hours   = 23;
+        minutes = 59;
+      }
+
+      snprintf(buffer, size, "%02ud%02uh%02um", days, hours, minutes);
+      return;
+    }
+
+    buffer[0] = '\0';
+    char chunk[12];
+    if (hours > 0)
+    {
+      snprintf(chunk, sizeof(chunk), "%02uh", hours);
+      strncat(buffer, chunk, size - strlen(buffer) - 1);
+    }
+    if (minutes > 0)
+    {
+      snprintf(chunk, sizeof(chunk), "%02um", minutes);
+      strncat(buffer, chunk, size - strlen(buffer) - 1);
+    }
+    snprintf(chunk, sizeof(chunk), "%02us", secs);
+    strncat(buffer, chunk, size - strlen(buffer) - 1);
+  }
+}
+
+namespace
+{
+  const char *const kUnits[] = { "A", "V", "W", "Wh", "C", "", nullptr };
+
+  uint32_t randomState = 0x12345678;
+
+  uint32_t nextRandom()
+  {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+  }
+
+  void checkValue(float value)
+  {
+    for (const char *unit : kUnits)
+    {
+      for (uint8_t digits = 2; digits <= 12; ++digits)
+      {
+        char expected[24];
+        char actual[24];
+        reference::formatValue(expected, sizeof(expected), value, unit, digits);
+        const size_t length = formatValue(actual, sizeof(actual), value, unit, digits);
+
+        char context[64];
+        snprintf(context, sizeof(context), "%.9g, %s, %u digits", value, unit ? unit : "null", digits);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, actual, context);
+        TEST_ASSERT_EQUAL_INT32_MESSAGE(strlen(expected), length, context);
+      }
+    }
+  }
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+// every prefix boundary and digit count change, with its float neighbours
+void test_format_value_boundaries()
+{
+  const float kEdges[] = { 0.0f, 1e-9f, 1e-8f, 1e-7f, 1e-6f, 1e-5f, 1e-4f, 1e-3f, 1e-2f, 1e-1f,
+                           1.0f, 10.0f, 100.0f, 1e3f, 1e4f, 1e5f, 1e6f, 0.5f, 0.05f, 999.9995f };
+  for (float edge : kEdges)
+  {
+    const float values[] = { edge, nextafterf(edge, 0.0f), nextafterf(edge, INFINITY) };
+    for (float value : values)
+    {
+      checkValue(value);
+      checkValue(-value);
+    }
+  }
+}
+
+void test_format_value_special()
+{
+  checkValue(-0.0f);
+  checkValue(INFINITY);
+  checkValue(-INFINITY);
+  checkValue(1e-45f); // smallest denormal
+}
+
+// half-way cases: decimal ties that are exact in binary
+void test_format_value_ties()
+{
+  for (int32_t i = -4000; i <= 4000; ++i)
+  {
+    checkValue(static_cast<float>(i) / 8.0f);
+    checkValue(static_cast<float>(i) / 1024.0f);
+  }
+}
+
+void test_format_value_random()
+{
+  for (uint32_t i = 0; i < 20000; ++i)
+  {
+    // uniform over the exponents the meter can produce, 1e-12 .. 1e7
+    const float mantissa = 1.0f + static_cast<float>(nextRandom() & 0xFFFFFF) / 16777216.0f;
+    const int   exp2     = static_cast<int>(nextRandom() % 64) - 40;
+    const float value    = ldexpf(mantissa, exp2);
+    checkValue((nextRandom() & 1) ? -value : value);
+  }
+}
+
+void test_format_decimal()
+{
+  for (uint32_t i = 0; i < 20000; ++i)
+  {
+    float value;
+    const uint32_t bits = nextRandom();
+    memcpy(&value, &bits, sizeof(value));
+    if (!isfinite(value) || fabsf(value) > 1e9f)
+      continue;
+
+    for (uint8_t decimals = 0; decimals <= 9; ++decimals)
+    {
+      char expected[48];
+      char actual[48];
+      snprintf(expected, sizeof(expected), "%.*f", decimals, value);
+      formatDecimal(actual, sizeof(actual), value, decimals);
+      TEST_ASSERT_EQUAL_STRING(expected, actual);
+    }
+  }
+}
+
+// identical up to 97 days; beyond that the old float argument lost seconds
+void test_format_time()
+{
+  const uint32_t kLimit = 97UL * 86400UL;
+  for (uint32_t seconds = 0; seconds < kLimit; seconds += (seconds < 400000) ? 1 : 61)
+  {
+    char expected[24];
+    char actual[24];
+    reference::formatTime(expected, sizeof(expected), static_cast<float>(seconds));
+    formatTime(actual, sizeof(actual), seconds);
+    TEST_ASSERT_EQUAL_STRING(expected, actual);
+  }
+}
+
+void test_truncation()
+{
+  char expected[8];
+  char actual[8];
+  reference::formatValue(expected, sizeof(expected), 123.456789f, "A", 8);
+  formatValue(actual, sizeof(actual), 123.456789f, "A", 8);
+  TEST_ASSERT_EQUAL_STRING(expected, actual);
+}
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_format_value_boundaries);
+  RUN_TEST(test_format_value_special);
+  RUN_TEST(test_format_value_ties);
+  RUN_TEST(test_format_value_random);
+  RUN_TEST(test_format_decimal);
+  RUN_TEST(test_format_time);
+  RUN_TEST(test_truncation);
+  return UNITY_END();
+}